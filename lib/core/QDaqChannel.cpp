@@ -4,6 +4,37 @@
 
 #include <algorithm>
 
+// the running sums are recomputed from the buffer after
+// this number of incremental updates to remove round-off drift
+#define SUM_RECOMPUTE_INTERVAL 65536
+
+// conversions to/from the muParser string type
+static mu::string_type toMuString(const QString& s)
+{
+#if defined(_UNICODE)
+    return s.toStdWString();
+#else
+    return s.toStdString();
+#endif
+}
+static QString fromMuString(const mu::string_type& s)
+{
+#if defined(_UNICODE)
+    return QString::fromStdWString(s);
+#else
+    return QString(s.c_str());
+#endif
+}
+
+// add v to the sum s with Kahan compensation c
+static inline void kahanAdd(double& s, double& c, double v)
+{
+    double y = v - c;
+    double t = s + y;
+    c = (t - s) - y;
+    s = t;
+}
+
 QDaqChannel::QDaqChannel(const QString& name) :
     QDaqJob(name),
     channeltype_(Normal),
@@ -14,16 +45,45 @@ QDaqChannel::QDaqChannel(const QString& name) :
     offset_(0.), multiplier_(1.),
     parser_(0),
     dataReady_(false),
-    counter_(0)
+    counter_(0),
+    pending_(0),
+    s1_(0.), s2_(0.), c1_(0.), c2_(0.),
+    sumCount_(0), sumUpdates_(0), sumValid_(false),
+    playbackIndex_(0),
+    compiled_(true),
+    process_(&QDaqChannel::process),
+    lazy_(false),
+    rng_(randomSeed())
 {
     range_ << -1e30 << 1.e30;
-    ff_ = 0.;
-    setForgettingFactor(0.99);
+    calibType_ = NoCalibration;
+    coldJunction_ = 0.;
+    ff_ = 0.99;
     depth_ = 1;
-    buff_.alloc(1);
-    sorted_buffer.resize(1);
+    ffd_ = ff_;
+    ffw_ = 1./(1. - ffd_);
+    buff_.alloc(2);
+    parserStride_ = 1;
+    parserX_.assign(1, 0.);
+    {
+        os::published<params_t>::editor p(params_);
+        p->type = channeltype_;
+        p->averaging = type_;
+        p->offset = offset_;
+        p->multiplier = multiplier_;
+        p->ff = ff_;
+        p->percentile = 50.;
+        p->range[0] = range_[0];
+        p->range[1] = range_[1];
+    }
+    adoptParams();
 }
 
+quint64 QDaqChannel::randomSeed()
+{
+    static QAtomicInteger<quint64> counter(0);
+    return QDaqTimeValue::nowNs() + 0x9e3779b97f4a7c15ULL*counter.fetchAndAddRelaxed(1);
+}
 QDaqChannel::~QDaqChannel(void)
 {
 	if (parser_) delete parser_;
@@ -34,6 +94,37 @@ void QDaqChannel::detach()
     QDaqJob::detach();
 }
 
+void QDaqChannel::adoptParams()
+{
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+    channeltype_ = p.type;
+    if (type_ != p.averaging)
+    {
+        type_ = p.averaging;
+        sumValid_ = false;
+    }
+    offset_ = p.offset;
+    multiplier_ = p.multiplier;
+    if (ff_ != p.ff)
+    {
+        ff_ = p.ff;
+        ffd_ = pow(ff_,(int)depth_);
+        ffw_ = 1./(1. - ffd_);
+        sumValid_ = false;
+    }
+    if (quantile_.quantile() != 0.01*p.percentile)
+        quantile_.setQuantile(0.01*p.percentile);
+    range_[0] = p.range[0];
+    range_[1] = p.range[1];
+    compile();
+}
+QDaqVector QDaqChannel::range() const
+{
+    QDaqVector v;
+    v << params_.staged().range[0] << params_.staged().range[1];
+    return v;
+}
 void QDaqChannel::setType(ChannelType t)
 {
     //if (throwIfArmed()) return;
@@ -41,18 +132,18 @@ void QDaqChannel::setType(ChannelType t)
     {
         QString msg(
             "Invalid channel type specification. Availiable options: "
-            "Normal, Clock, Random, Inc, Dec."
+            "Normal, Clock, Random, Inc, Dec, Playback."
             );
         throwScriptError(msg);
         return;
     }
-    if (channeltype_ != t)
+    if (type() != t)
     {
         {
-            QMutexLocker L(&comm_lock);
-            channeltype_ = t;
-            if (t==Clock) setFormat(Time);
+            os::published<params_t>::editor p(params_);
+            p->type = t;
         }
+        if (t==Clock) setFormat(Time);
         emit propertiesChanged();
     }
 }
@@ -68,7 +159,7 @@ void QDaqChannel::setUnit(QString v)
 }
 void QDaqChannel::setRange(const QDaqVector &v)
 {
-    if((v!=range_) && (!v.isEmpty()) && (v.size()==2) && std::isfinite(v[0]) && std::isfinite(v[1]) && (v[1]!=v[0]))
+    if((v!=range()) && (!v.isEmpty()) && (v.size()==2) && std::isfinite(v[0]) && std::isfinite(v[1]) && (v[1]!=v[0]))
 	{
 		// fix ordering
         QDaqVector myv(v);
@@ -77,20 +168,23 @@ void QDaqChannel::setRange(const QDaqVector &v)
             myv << v[1] << v[0];
         }
 		// set the range
-        QMutexLocker L(&comm_lock);
-		range_ = myv;
+        {
+            os::published<params_t>::editor p(params_);
+            p->range[0] = myv[0];
+            p->range[1] = myv[1];
+        }
 		emit propertiesChanged();
 	}
 }
 void QDaqChannel::setOffset(double v)
 {
-    QMutexLocker L(&comm_lock);
-	offset_ = v;
+    os::published<params_t>::editor p(params_);
+    p->offset = v;
 }
 void QDaqChannel::setMultiplier(double v)
 {
-    QMutexLocker L(&comm_lock);
-	multiplier_ = v;
+    os::published<params_t>::editor p(params_);
+    p->multiplier = v;
 }
 void QDaqChannel::setAveraging(AveragingType t)
 {
@@ -104,11 +198,11 @@ void QDaqChannel::setAveraging(AveragingType t)
 		throwScriptError(msg);
 		return;
 	}
-	if (type_ != t)
+	if (averaging() != t)
 	{
 		{
-            QMutexLocker L(&comm_lock);
-			type_ = t;
+            os::published<params_t>::editor p(params_);
+            p->averaging = t;
 		}
 		emit propertiesChanged();
 	}
@@ -118,85 +212,82 @@ void QDaqChannel::setDepth(uint d)
 	if ((d!=depth_) && d>0)
 	{
 		{
-            QMutexLocker L(&comm_lock);
+            JobLocker L(this);
 			depth_ = d;
-			buff_.alloc(d);
-            sorted_buffer.resize(d);
-            ffw_ = 1. / (1. - pow(ff_,(int)d));
+			// in block mode the buffer holds a full block of new samples
+			// plus the one leaving the averaging window
+			buff_.alloc(d + blockSize_);
+            quantile_.setWindow(d);
+            ffd_ = pow(ff_,(int)d);
+            ffw_ = 1. / (1. - ffd_);
+            sumValid_ = false;
 		}
 		emit propertiesChanged();
 	}
 }
 bool QDaqChannel::arm_()
 {
+    adoptParams();
 	counter_ = 0;
+    pending_ = 0;
+    playbackIndex_ = 0;
 	dataReady_ = false;
+    sumValid_ = false;
+    if (buff_.capacity() < depth_ + blockSize_)
+        buff_.alloc(depth_ + blockSize_);
+    block_.assign(blockSize_>1 ? blockSize_ : 0, 0.);
+    if (!bindParser()) return false;
+    if (!updateCalibration())
+    {
+        throwScriptError("Invalid calibration coefficients.");
+        return false;
+    }
+    compile();
+    publish();
     return QDaqJob::arm_();
 }
-bool QDaqChannel::average()
+template<QDaqChannel::AveragingType A>
+bool QDaqChannel::averageT(uint off)
 {
-    int m = (counter_ < depth_) ? counter_ : depth_;
+    // the sample at offset off is the one when counter was c
+    uint c = counter_ - off;
+    int m = (c < depth_) ? c : depth_;
     if (m==0) return false;
 
-	if (type_==None || m==1)
+	if (A==None || m==1)
 	{
-		v_ = buff_[0];
+		v_ = buff_[off];
         dv_ = 0;
 		return true;
 	}
 
-    v_ = dv_ = 0;
+    // bring the running sums up to sample c.
+    // Recompute if the samples needed are no longer in the buffer
+    uint n = c - sumCount_;
+    if (!sumValid_ || c < sumCount_ || n > depth_ ||
+            counter_ - sumCount_ + depth_ > buff_.capacity() ||
+            sumUpdates_ >= SUM_RECOMPUTE_INTERVAL)
+        recomputeSums(off,c,m);
+    else
+        for(uint j=n; j-- > 0; ) addSampleT<A>(off + j, c - j);
 
-	double wt;
-    int sw, m2;
-    switch(type_)
+    switch(A)
 	{
 	case Running:
-		for(int i=0; i<m; ++i)
-		{
-			double y = buff_[i];
-			v_ += y;
-			dv_ += y*y;
-		}
-		v_ /= m;
-		dv_ /= m;
+		v_ = s1_/m;
+		dv_ = s2_/m;
 		break;
     case Median:
-        for(int i=0; i<m; ++i)
-        {
-            sorted_buffer[i] = buff_[i];
-            double y = buff_[i];
-            dv_ += y*y;
-        }
-        std::sort(sorted_buffer.begin(),sorted_buffer.end()); //needs #include <algorithm>
-        m2 = m/2;
-        if (m % 2) { v_ = sorted_buffer[m2];}
-        else v_ = (sorted_buffer[m2-1] + sorted_buffer[m2])/2.0;
-        dv_ /= m;
+        v_ = quantile_.value();
+        dv_ = s2_/m;
         break;
     case Delta:
-		sw = ((counter_ & 1) == 1) ? -1 : 1; // get the current sign
-		for(int i=1; i<m; ++i)
-		{
-			double y = (buff_[i]-buff_[i-1]);
-			v_ += y*sw;
-			dv_ += y*y;
-			sw = - sw;
-		}
-		v_  /= (2*(m-1));
-		dv_ /= (4*(m-1));
+		v_  = s1_/(2*(m-1));
+		dv_ = s2_/(4*(m-1));
 		break;
 	case ForgettingFactor:
-		wt = 1-ff_; // weight factor
-		for(int i=0; i<m; ++i)
-		{
-			double y = buff_[i];
-			v_ += y*wt;
-			dv_ += y*y*wt;
-			wt *= ff_;
-		}
-		v_ *= ffw_;
-		dv_ *= ffw_;
+		v_ = s1_*(1-ff_)*ffw_;
+		dv_ = s2_*(1-ff_)*ffw_;
 		break;
     case None:
         break;
@@ -211,52 +302,208 @@ bool QDaqChannel::average()
 	return true;
 }
 
+void QDaqChannel::recomputeSums(uint off, uint c, uint m)
+{
+    s1_ = s2_ = c1_ = c2_ = 0.;
+
+    double wt;
+    int sw;
+    switch(type_)
+    {
+    case Median:
+        quantile_.clear();
+        for(uint i=m; i-- > 0; ) quantile_.push(buff_[i+off],c-i);
+        // fall through
+    case Running:
+        for(uint i=0; i<m; ++i)
+        {
+            double y = buff_[i+off];
+            kahanAdd(s1_,c1_,y);
+            kahanAdd(s2_,c2_,y*y);
+        }
+        break;
+    case Delta:
+        sw = ((c & 1) == 1) ? -1 : 1; // get the current sign
+        for(uint i=1; i<m; ++i)
+        {
+            double y = (buff_[i+off]-buff_[i+off-1]);
+            kahanAdd(s1_,c1_,y*sw);
+            kahanAdd(s2_,c2_,y*y);
+            sw = - sw;
+        }
+        break;
+    case ForgettingFactor:
+        wt = 1.;
+        for(uint i=0; i<m; ++i)
+        {
+            double y = buff_[i+off];
+            s1_ += y*wt;
+            s2_ += y*y*wt;
+            wt *= ff_;
+        }
+        break;
+    case None:
+        break;
+    }
+
+    sumCount_ = c;
+    sumUpdates_ = 0;
+    sumValid_ = true;
+}
+template<QDaqChannel::AveragingType A>
+void QDaqChannel::addSampleT(uint off, uint k)
+{
+    // sample k enters the window. If the window is full
+    // the sample k-depth_ (at off + depth_) leaves
+    double y = buff_[off];
+    bool full = k > depth_;
+    double d;
+    switch(A)
+    {
+    case Median:
+        quantile_.push(y,k);
+        // fall through
+    case Running:
+        kahanAdd(s1_,c1_,y);
+        kahanAdd(s2_,c2_,y*y);
+        if (full)
+        {
+            double yo = buff_[off + depth_];
+            kahanAdd(s1_,c1_,-yo);
+            kahanAdd(s2_,c2_,-yo*yo);
+        }
+        break;
+    case Delta:
+        // the difference y(j) - y(j+1) enters the sum with sign (-1)^(j+1)
+        if (k>1)
+        {
+            d = buff_[off+1] - y; // j = k-1
+            kahanAdd(s1_,c1_,(k & 1) ? -d : d);
+            kahanAdd(s2_,c2_,d*d);
+        }
+        if (full)
+        {
+            d = buff_[off + depth_] - buff_[off + depth_ - 1]; // j = k-depth_
+            kahanAdd(s1_,c1_,((k - depth_) & 1) ? -d : d);
+            kahanAdd(s2_,c2_,-d*d);
+        }
+        break;
+    case ForgettingFactor:
+        // S(k) = y(k) + ff*S(k-1) - ff^depth*y(k-depth)
+        s1_ = ff_*s1_ + y;
+        s2_ = ff_*s2_ + y*y;
+        if (full)
+        {
+            double yo = buff_[off + depth_];
+            s1_ -= ffd_*yo;
+            s2_ -= ffd_*yo*yo;
+        }
+        break;
+    case None:
+        break;
+    }
+
+    sumCount_ = k;
+    sumUpdates_++;
+}
+bool QDaqChannel::average(uint off)
+{
+    switch(type_)
+    {
+    case Running: return averageT<Running>(off);
+    case Delta: return averageT<Delta>(off);
+    case ForgettingFactor: return averageT<ForgettingFactor>(off);
+    case Median: return averageT<Median>(off);
+    case None:
+    default: return averageT<None>(off);
+    }
+}
 bool QDaqChannel::run()
 {
     if (!QDaqJob::run()) return false;
 
-    dataReady_ = true;
+    adoptParams();
+
+    bool more = generate(1);
+
+    bool ready = dataReady_;
+    bool updated = (this->*process_)(0);
+    pending_ = 0;
+
+    if (updated || ready != dataReady_) publish();
+    if (updated) notify(NotifyWidgets);
+
+    return more;
+}
+bool QDaqChannel::runBlock(uint n)
+{
+    if (!QDaqJob::run()) return false;
+
+    adoptParams();
+
+    bool more = generate(n);
+
+    // process the new samples from the oldest to the newest
+    uint m = pending_ < n ? pending_ : n;
+    if (m==0) m = 1;
+    bool ready = dataReady_;
+    bool updated = false;
+    if (parser_ && n <= parserStride_)
+        updated = processBlockParsed(n, m);
+    else
+    {
+        for(uint k=m; k-- > 0; )
+        {
+            if ((this->*process_)(k)) updated = true;
+            block_[n-1-k] = v_;
+        }
+        // missing samples at the start of the block repeat the first one
+        for(uint j=0; j<n-m; ++j) block_[j] = block_[n-m];
+    }
+    pending_ = 0;
+
+    if (updated || ready != dataReady_) publish();
+    if (updated) notify(NotifyWidgets);
+
+    return more;
+}
+bool QDaqChannel::generate(uint n)
+{
+    double x = v_;
     switch (channeltype_)
     {
     case Clock:
-        push(QDaqTimeValue::now());
+        for(uint i=0; i<n; ++i) push(sampleTime(n-1-i));
         break;
     case Random:
-        push(1.*rand()/RAND_MAX);
+        for(uint i=0; i<n; ++i) push(rng_.uniform());
         break;
     case Inc:
-        push(v_ + 1);
+        for(uint i=0; i<n; ++i) push(x += 1);
         break;
     case Dec:
-        push(v_ - 1);
+        for(uint i=0; i<n; ++i) push(x -= 1);
+        break;
+    case Playback:
+        for(uint i=0; i<n; ++i)
+        {
+            if (playbackIndex_ >= (uint)playback_.size()) return false;
+            push(playback_[playbackIndex_++]);
+        }
         break;
     case Normal:
     default:
         break;
     }
-
-    if ((dataReady_=average()))
+    return true;
+}
+bool QDaqChannel::process(uint off)
+{
+    if ((dataReady_=average(off)))
 	{
-		if (parser_)
-		{
-			try
-			{
-			  v_ = parser_->Eval();
-			}
-			catch (mu::Parser::exception_type &e)
-			{
-				//Q_UNUSED(e);
-
-                const mu::string_type& msg = e.GetMsg();
-#if defined(_UNICODE)
-                pushError(QString("muParser"),QString::fromStdWString(msg));
-#else
-				pushError(QString("muParser"),QString(msg.c_str()));
-#endif
-				//std::cout << e.GetMsg() << endl;
-				dataReady_ = false;
-			}
-		}
+		if (parser_) evalParser();
+
+		if (calib_.active()) calibrate();
 
 		{
 			v_ = multiplier_*v_ + offset_;
@@ -269,36 +516,302 @@ bool QDaqChannel::run()
 
         dataReady_ = std::isfinite(v_);
 
-        emit updateWidgets();
+        return true;
 	}
 
+    return false;
+}
+void QDaqChannel::evalParser()
+{
+    parserX_[0] = v_;
+    for(int i=0; i<parserChannels_.size(); ++i)
+    {
+        QDaqChannel* ch = parserChannels_[i];
+        parserIn_[i*parserStride_] = ch ? ch->value() : NAN;
+    }
+    try
+    {
+      v_ = parser_->Eval();
+    }
+    catch (mu::Parser::exception_type &e)
+    {
+        pushError(QString("muParser"),fromMuString(e.GetMsg()));
+        dataReady_ = false;
+    }
+}
+bool QDaqChannel::bindParser()
+{
+    parserChannels_.clear();
+    parserStride_ = blockSize_ > 1 ? blockSize_ : 1;
+    parserX_.assign(parserStride_, 0.);
+    parserOut_.assign(parserStride_, 0.);
+    parserDv_.assign(parserStride_, 0.);
+    parserOk_.assign(parserStride_, 0);
+    if (!parser_)
+    {
+        parserIn_.clear();
+        return true;
+    }
+
+    // find the variables used in the expression
+    QStringList names;
+    try
+    {
+        parser_->ClearVar();
+        const mu::varmap_type& vars = parser_->GetUsedVar();
+        for(mu::varmap_type::const_iterator it = vars.begin(); it!=vars.end(); ++it)
+        {
+            QString name = fromMuString(it->first);
+            if (name != "x") names << name;
+        }
+    }
+    catch (mu::Parser::exception_type &e)
+    {
+        throwScriptError(QString("muParser: %1").arg(fromMuString(e.GetMsg())));
+        return false;
+    }
+
+    // resolve them to channels
+    foreach(const QString& name, names)
+    {
+        QDaqChannel* ch = qobject_cast<QDaqChannel*>(fromPath(name));
+        if (!ch)
+        {
+            throwScriptError(QString("%1 in parserExpression is not a QDaqChannel.").arg(name));
+            return false;
+        }
+        parserChannels_ << ch;
+    }
+
+    parserIn_.assign(names.size()*parserStride_, 0.);
+    parser_->DefineVar(toMuString("x"), parserX_.data());
+    for(int i=0; i<names.size(); ++i)
+        parser_->DefineVar(toMuString(names[i]), &parserIn_[i*parserStride_]);
+    return true;
+}
+bool QDaqChannel::processBlockParsed(uint n, uint m)
+{
+    // average the new samples, oldest first
+    double vlast = v_;
+    for(uint k=m; k-- > 0; )
+    {
+        uint j = n-1-k;
+        parserOk_[j] = average(k);
+        parserX_[j] = v_;
+        parserDv_[j] = dv_;
+    }
+    for(uint j=0; j<n-m; ++j) parserX_[j] = parserX_[n-m];
+
+    // channel variables, per sample if they are in the same loop
+    for(int i=0; i<parserChannels_.size(); ++i)
+    {
+        QDaqChannel* ch = parserChannels_[i];
+        double* p = &parserIn_[i*parserStride_];
+        if (!ch)
+            for(uint j=0; j<n; ++j) p[j] = NAN;
+        else ch->blockValues(p, n, top_);
+    }
+
+    // evaluate the whole block at once
+    try
+    {
+        parser_->Eval(parserOut_.data(), n);
+    }
+    catch (mu::Parser::exception_type &e)
+    {
+        pushError(QString("muParser"),fromMuString(e.GetMsg()));
+        for(uint j=0; j<n; ++j) parserOk_[j] = 0;
+    }
+
+    // scale and check range as in process()
+    bool updated = false;
+    v_ = vlast;
+    for(uint j=n-m; j<n; ++j)
+    {
+        if (parserOk_[j])
+        {
+            v_ = parserOut_[j];
+            dv_ = parserDv_[j];
+            if (calib_.active()) calibrate();
+            v_ = multiplier_*v_ + offset_;
+            dv_ = multiplier_*dv_ + offset_;
+            if (v_ < range_[0]) v_ = range_[0];
+            if (v_ > range_[1]) v_ = range_[1];
+            dataReady_ = std::isfinite(v_);
+            updated = true;
+        }
+        else dataReady_ = false;
+        block_[j] = v_;
+    }
+    // missing samples at the start of the block repeat the first one
+    for(uint j=0; j<n-m; ++j) block_[j] = block_[n-m];
+    return updated;
+}
+template<QDaqChannel::AveragingType A, bool Parse, bool Scale>
+bool QDaqChannel::processT(uint off)
+{
+    // same as process() with the stages fixed at compile time
+    if (!(dataReady_ = averageT<A>(off))) return false;
+
+    if (Parse) evalParser();
+
+    if (calib_.active()) calibrate();
+
+    if (Scale)
+    {
+        v_ = multiplier_*v_ + offset_;
+        dv_ = multiplier_*dv_ + offset_;
+    }
+
+    if (v_ < range_[0]) v_ = range_[0];
+    if (v_ > range_[1]) v_ = range_[1];
+
+    dataReady_ = std::isfinite(v_);
+
+    return true;
+}
+template<QDaqChannel::AveragingType A>
+QDaqChannel::process_t QDaqChannel::selectProcess(bool parse, bool scale)
+{
+    if (parse) return scale ? &QDaqChannel::processT<A,true,true> : &QDaqChannel::processT<A,true,false>;
+    else return scale ? &QDaqChannel::processT<A,false,true> : &QDaqChannel::processT<A,false,false>;
+}
+void QDaqChannel::compile()
+{
+    if (!compiled_)
+    {
+        process_ = &QDaqChannel::process;
+        return;
+    }
+    bool parse = parser_ != 0;
+    bool scale = multiplier_ != 1. || offset_ != 0.;
+    switch(type_)
+    {
+    case Running: process_ = selectProcess<Running>(parse,scale); break;
+    case Delta: process_ = selectProcess<Delta>(parse,scale); break;
+    case ForgettingFactor: process_ = selectProcess<ForgettingFactor>(parse,scale); break;
+    case Median: process_ = selectProcess<Median>(parse,scale); break;
+    case None:
+    default: process_ = selectProcess<None>(parse,scale); break;
+    }
+}
+void QDaqChannel::setCompiled(bool on)
+{
+    if (on != compiled_)
+    {
+        {
+            JobLocker L(this);
+            compiled_ = on;
+            compile();
+        }
+        emit propertiesChanged();
+    }
+}
+bool QDaqChannel::updateCalibration()
+{
+    std::vector<double> c(calibCoef_.constData(), calibCoef_.constData() + calibCoef_.size());
+    std::vector<double> b(calibBreaks_.constData(), calibBreaks_.constData() + calibBreaks_.size());
+    math::calibration cal;
+    if (!cal.set((math::calibration::type_t)calibType_, c, b, coldJunction_)) return false;
+    JobLocker L(this);
+    calib_ = cal;
     return true;
 }
+void QDaqChannel::setCalibration(CalibrationType t)
+{
+    if ((int)t==-1)
+    {
+        throwScriptError("Invalid calibration specification. Availiable options: "
+                         "NoCalibration, Polynomial, Piecewise, TypeK, TypeJ, TypeT, TypeE, Rtd");
+        return;
+    }
+    if (t != calibType_)
+    {
+        calibType_ = t;
+        // inconsistent settings are reported when the channel is armed
+        if (!updateCalibration() && armed())
+            throwScriptError("Invalid calibration coefficients.");
+        emit propertiesChanged();
+    }
+}
+void QDaqChannel::setCalibrationCoefficients(const QDaqVector& v)
+{
+    calibCoef_ = v;
+    if (!updateCalibration() && armed())
+        throwScriptError("Invalid calibration coefficients.");
+    emit propertiesChanged();
+}
+void QDaqChannel::setCalibrationBreakpoints(const QDaqVector& v)
+{
+    calibBreaks_ = v;
+    if (!updateCalibration() && armed())
+        throwScriptError("Invalid calibration breakpoints.");
+    emit propertiesChanged();
+}
+void QDaqChannel::setColdJunction(double t)
+{
+    if (t != coldJunction_)
+    {
+        coldJunction_ = t;
+        updateCalibration();
+        emit propertiesChanged();
+    }
+}
+void QDaqChannel::publish()
+{
+    Sample s;
+    s.value = v_;
+    s.std = dv_;
+    s.time = sampleTime();
+    s.ready = dataReady_;
+    out_.write(s);
+}
+void QDaqChannel::blockValues(double* dst, uint n, const QDaqLoop* top) const
+{
+    if (lazy_ || !top || top_!=top || !armed())
+    {
+        std::fill(dst, dst + n, value());
+        return;
+    }
+    uint m = n < block_.size() ? n : block_.size();
+    if (m) std::copy(block_.begin(), block_.begin() + m, dst);
+    for(uint j=m; j<n; ++j) dst[j] = v_;
+}
+void QDaqChannel::invalidate()
+{
+    dataReady_ = false;
+    publish();
+    QDaqJob::invalidate();
+}
 QString QDaqChannel::formatedValue()
 {
 	QString ret;
+	double v = value();
 	switch(fmt_)
 	{
 	case General:
-		return QString::number(v_,'g',digits_);
+		return QString::number(v,'g',digits_);
 	case FixedPoint:
-		return QString::number(v_,'f',digits_);
+		return QString::number(v,'f',digits_);
 	case Scientific:
-		return QString::number(v_,'e',digits_);
+		return QString::number(v,'e',digits_);
 	case Time:
-        return QDaqTimeValue(v_).toString();
+        return QDaqTimeValue(v).toString();
 	}
 
-	return QString::number(v_);
+	return QString::number(v);
 //	return dataReady_ ?
 //		(time_channel_ ? RtTimeValue(v_).toString() : QString::number(v_)) : QString();
 }
 
 void QDaqChannel::clear()
 {
-    QMutexLocker L(&comm_lock);
+    JobLocker L(this);
 	counter_ = 0;
+    pending_ = 0;
 	dataReady_ = false;
+    sumValid_ = false;
+    publish();
 }
 
 
@@ -313,19 +826,40 @@ QString QDaqChannel::parserExpression() const
 }
 void QDaqChannel::setForgettingFactor(double v)
 {
-	if (v!=ff_ && v>0. && v<1.)
+	if (v!=forgettingFactor() && v>0. && v<1.)
+	{
+        {
+            os::published<params_t>::editor p(params_);
+            p->ff = v;
+        }
+		emit propertiesChanged();
+	}
+}
+void QDaqChannel::setPercentile(double v)
+{
+	if (v!=percentile() && v>=0. && v<=100.)
 	{
-        QMutexLocker L(&comm_lock);
-		ff_ = v;
-		ffw_ = 1./(1. - pow(ff_,(int)depth_));
+        {
+            os::published<params_t>::editor p(params_);
+            p->percentile = v;
+        }
 		emit propertiesChanged();
 	}
 }
+void QDaqChannel::setPlaybackData(const QDaqVector &v)
+{
+    {
+        JobLocker L(this);
+        playback_ = v;
+        playbackIndex_ = 0;
+    }
+    emit propertiesChanged();
+}
 void QDaqChannel::setParserExpression(const QString& s)
 {
 	if (s!=parserExpression())
 	{
-        QMutexLocker L(&comm_lock);
+        JobLocker L(this);
 
 		if (s.isEmpty())
 		{
@@ -334,22 +868,38 @@ void QDaqChannel::setParserExpression(const QString& s)
 		}
 		else
 		{
-#if defined(_UNICODE)
             if (!parser_)
             {
                 parser_= new mu::Parser();
-                parser_->DefineVar(QString("x").toStdWString(),&v_);
+                // '.' is allowed in variable names for channel paths
+                parser_->DefineNameChars(toMuString("0123456789_."
+                    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ").c_str());
+            }
+            // check the syntax. While armed the variables are also bound,
+            // otherwise this is done when the channel is armed
+            bool ok = true;
+            try
+            {
+                parser_->SetExpr(toMuString(s));
+                if (!armed())
+                {
+                    parser_->ClearVar();
+                    parser_->GetUsedVar();
+                }
+            }
+            catch (mu::Parser::exception_type &e)
+            {
+                throwScriptError(QString("muParser: %1").arg(fromMuString(e.GetMsg())));
+                ok = false;
+            }
+            if (ok && armed()) ok = bindParser();
+            if (!ok)
+            {
+                delete parser_;
+                parser_ = 0;
             }
-            parser_->SetExpr(s.toStdWString());
-#else
-			if (!parser_)
-			{
-				parser_= new mu::Parser();
-				parser_->DefineVar("x",&v_);
-			}
-			parser_->SetExpr(s.toStdString());
-#endif
 		}
+		compile();
 
 		emit propertiesChanged();
 	}
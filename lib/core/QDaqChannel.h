@@ -5,6 +5,9 @@
 #include "QDaqTypes.h"
 
 #include "math_util.h"
+#include "calibration.h"
+#include "os_util.h"
+#include <QPointer>
 #include <vector>
 
 namespace mu
@@ -63,6 +66,8 @@ class QDAQ_EXPORT QDaqChannel : public QDaqJob
 	*/
 	Q_PROPERTY(double multiplier READ multiplier WRITE setMultiplier)
 	/** Type of on-line averaging.
+	Running, Delta and ForgettingFactor averages are updated incrementally,
+	thus their cost per sample does not depend on depth.
 	*/
 	Q_PROPERTY(AveragingType averaging READ averaging WRITE setAveraging)
 	/** Forgetting factor value.
@@ -73,29 +78,72 @@ class QDAQ_EXPORT QDaqChannel : public QDaqJob
 	Number of past data values used in averaging.
 	*/
 	Q_PROPERTY(uint depth READ depth WRITE setDepth)
+	/** Percentile computed by Median averaging.
+	A value between 0 and 100. The default 50 gives the median.
+	*/
+	Q_PROPERTY(double percentile READ percentile WRITE setPercentile)
 	/** Channel memory used.
 	Number of values stored in internal channel memory.
 	*/
 	Q_PROPERTY(uint memsize READ memsize)
 	/** True if valid data exist on the channel.
 	If dataReady is true, then value() & std() return valid numbers.
+	Use snapshot() to obtain ready, value and std that belong to the same sample.
 	*/
 	Q_PROPERTY(bool dataReady READ dataReady)
 	/** muParser Expression.
 	If set the expression is executed on the channel data.
 	Note that the data goes first through muParser and then they are scaled with multiplier and offset.
+	The channel value is the variable x. Other channels can be used as variables
+	by their path, e.g. "sqrt(loop.ch1^2 + loop.ch2^2)".
+	Channel variables are resolved when the channel is armed; in block mode
+	they should be in the same loop, so that their values per sample are used,
+	and the expression is evaluated for the whole block in one call.
 	*/
 	Q_PROPERTY(QString parserExpression READ parserExpression WRITE setParserExpression)    
+	/** Recorded data for a Playback channel.
+	At each repetition the next value is inserted in the channel.
+	When the data are exhausted the channel stops its loop.
+	*/
+	Q_PROPERTY(QDaqVector playbackData READ playbackData WRITE setPlaybackData)
+	/** Use the compiled processing pipeline.
+	The channel selects a processing function specialized for its averaging type
+	and for whether a parser expression and scaling are set, thus stages that are
+	not configured cost nothing. The selection is done when the channel is armed
+	or its configuration changes. If false, the generic implementation is used.
+	Both give identical results. Default is true.
+	*/
+	Q_PROPERTY(bool compiled READ compiled WRITE setCompiled)
+	/** Calibration curve.
+	Converts the channel data to physical units. It is applied after
+	the parserExpression and before multiplier and offset. The std is
+	propagated with the derivative of the curve.
+	See math::calibration for the curve definitions.
+	*/
+	Q_PROPERTY(CalibrationType calibration READ calibration WRITE setCalibration)
+	/** Calibration coefficients.
+	Polynomial: c0, c1, ..., cn. Piecewise: the coefficients of all segments,
+	in the local variable x - bk. Rtd: R0 or R0, A, B, C (default Pt100).
+	Not used by thermocouples.
+	*/
+	Q_PROPERTY(QDaqVector calibrationCoefficients READ calibrationCoefficients WRITE setCalibrationCoefficients)
+	/** Breakpoints of a Piecewise calibration, in increasing order.
+	*/
+	Q_PROPERTY(QDaqVector calibrationBreakpoints READ calibrationBreakpoints WRITE setCalibrationBreakpoints)
+	/** Reference (cold) junction temperature of a thermocouple in degC.
+	*/
+	Q_PROPERTY(double coldJunction READ coldJunction WRITE setColdJunction)
 
 public:
     /** Type of the channel.
     */
     enum ChannelType {
         Normal,  /**< Normal channel - nothing special. */
-        Clock,    /**< Records time in each repetition. Can be used for time measurement. */
+        Clock,    /**< Records the loop time stamp in each repetition. Can be used for time measurement. */
         Random,  /**< Generates random samples. */
         Inc,     /**< Starting from an initial value increments by 1 in each repetition. */
-        Dec      /**< Starting from an initial value decrements by 1 in each repetition. */
+        Dec,     /**< Starting from an initial value decrements by 1 in each repetition. */
+        Playback /**< Inserts the next value of playbackData in each repetition. */
     };
     Q_ENUM(ChannelType)
 
@@ -106,7 +154,7 @@ public:
 		Running, /**< Running (box) averaging. */
 		Delta, /**< Running average for signals of alternating sign. */
         ForgettingFactor, /**< Running average with forgetting (exponential weighting). */
-        Median /**< Running median filter. */
+        Median /**< Running median (or percentile) filter. */
     };
     Q_ENUM(AveragingType)
 
@@ -120,6 +168,20 @@ public:
 	};
     Q_ENUM(NumberFormat)
 
+    /** Type of calibration curve.
+    */
+    enum CalibrationType {
+        NoCalibration, /**< No calibration. */
+        Polynomial, /**< Polynomial. */
+        Piecewise, /**< Piecewise polynomial. */
+        TypeK, /**< Type K thermocouple, mV to degC. */
+        TypeJ, /**< Type J thermocouple, mV to degC. */
+        TypeT, /**< Type T thermocouple, mV to degC. */
+        TypeE, /**< Type E thermocouple, mV to degC. */
+        Rtd /**< Platinum resistance thermometer, Ohm to degC. */
+    };
+    Q_ENUM(CalibrationType)
+
 protected:
     ChannelType channeltype_;
 	QString signalName_, unit_;
@@ -130,16 +192,100 @@ protected:
     mu::Parser* parser_;
     bool dataReady_;
     QDaqVector range_;
+    // calibration settings and the curve in use
+    CalibrationType calibType_;
+    QDaqVector calibCoef_, calibBreaks_;
+    double coldJunction_;
+    math::calibration calib_;
+    // build calib_ from the settings. Returns false if they are inconsistent
+    bool updateCalibration();
+    // apply calib_ to v_, dv_
+    void calibrate()
+    {
+        double d;
+        v_ = calib_(v_, d);
+        dv_ = std::fabs(d)*dv_;
+    }
     // a counter incremented at each new value
     uint counter_;
+    // values pushed since the last run
+    uint pending_;
 	uint depth_;
 	double ff_, ffw_;
+	// ff_^depth_
+	double ffd_;
+
+	// running sums for averaging. They are updated incrementally
+	// as samples enter and leave the averaging window
+	double s1_, s2_;
+	// Kahan compensation terms of s1_, s2_
+	double c1_, c2_;
+	// counter_ value of the newest sample included in the sums
+	uint sumCount_;
+	// incremental updates since the sums were last recomputed
+	uint sumUpdates_;
+	// false if the sums must be recomputed
+	bool sumValid_;
 
 	// channel buffer
     math::circular_buffer<double> buff_;
 
-    //buffer used for median
-    std::vector<double> sorted_buffer;
+    // processed values of the last block (block mode only)
+    std::vector<double> block_;
+
+    // recorded data for Playback channels
+    QDaqVector playback_;
+    uint playbackIndex_;
+
+    // the processing function, process() or one of processT()
+    bool compiled_;
+    typedef bool (QDaqChannel::*process_t)(uint off);
+    process_t process_;
+    // select process_ according to the channel configuration
+    void compile();
+    template<AveragingType A>
+    static process_t selectProcess(bool parse, bool scale);
+    // process() specialized at compile time
+    template<AveragingType A, bool Parse, bool Scale>
+    bool processT(uint off);
+
+    // sliding window order statistics for median
+    math::sliding_quantile<double> quantile_;
+
+public:
+    /// The channel output as seen by other threads.
+    struct Sample
+    {
+        double value;
+        double std;
+        double time; ///< sample time, see QDaqJob::sampleTime()
+        bool ready;
+    };
+
+protected:
+    // the last published output, read lock-free by value(), std(), snapshot()
+    os::seqlock<Sample> out_;
+    // publish v_, dv_, dataReady_ to out_. Called by the loop thread after
+    // each update and by functions that change the output under the job lock
+    void publish();
+    // true if the output is computed when read (see QDaqVirtualChannel)
+    bool lazy_;
+    // compute and publish the output of a lazy channel
+    virtual void refresh() {}
+
+    // Parameters that can be changed while the channel runs.
+    // Setters write the staged copy, run() adopts it
+    // at the start of each repetition without locking.
+    struct params_t {
+        ChannelType type;
+        AveragingType averaging;
+        double offset, multiplier, ff, percentile;
+        double range[2];
+    };
+    os::published<params_t> params_;
+
+    // copy published parameters to the working members
+    void adoptParams();
 
 
 	virtual bool arm_();
@@ -156,14 +302,62 @@ protected:
      *   - the mean value is scaled and shifted (multiplier*v + offset)
      *   - the mean value is checked for under/over range
      *
-     * If new data is available the updateWidgets signal is emitted.
+     * If new data is available the updateWidgets signal is requested (see notify()).
      *
      * @return always return true.
      */
     virtual bool run();
 
+    /**
+     * @brief Perform channel tasks on a block of n samples.
+     *
+     * The values pushed since the last repetition are processed one by one
+     * as in run(), in the order they were inserted, and the results are
+     * stored in the block returned by blockValue(). If fewer than n values
+     * were pushed, the first block entries repeat the oldest processed value.
+     *
+     * The updateWidgets signal is requested once per block.
+     */
+    virtual bool runBlock(uint n);
+
+    // generate n samples for the special channel types
+    // returns false if playback data are exhausted
+    virtual bool generate(uint n);
+
+    // random number generator of Random channels
+    math::xoshiro256 rng_;
+    // a new seed for each call, different in each run of the program
+    static quint64 randomSeed();
+    // average, transform and check the sample inserted off values ago
+    bool process(uint off);
+
 	// do the averaging operations in the channel
-	bool average();
+	bool average(uint off = 0);
+	template<AveragingType A>
+	bool averageT(uint off);
+	// recompute the running sums for the sample off values ago
+	void recomputeSums(uint off, uint c, uint m);
+	// update the running sums with sample k at offset off
+	template<AveragingType A>
+	void addSampleT(uint off, uint k);
+	// evaluate the muParser expression on v_
+	void evalParser();
+
+	// muParser variables: x and the channels used in the expression,
+	// stored in rows of parserStride_ values (1 or the loop blockSize)
+	uint parserStride_;
+	std::vector<double> parserX_, parserIn_;
+	QVector< QPointer<QDaqChannel> > parserChannels_;
+	// per sample results, std and ready flags in block mode
+	std::vector<double> parserOut_, parserDv_;
+	std::vector<char> parserOk_;
+	// resolve the expression variables and bind them to the arrays above
+	bool bindParser();
+	// process n samples of a block (m new ones) with one bulk evaluation
+	bool processBlockParsed(uint n, uint m);
+
+    // marks the channel data as not ready
+    virtual void invalidate();
 
 public:
     Q_INVOKABLE explicit QDaqChannel(const QString& name);
@@ -172,20 +366,27 @@ public:
 	virtual void detach();
 
 	// getters
-    ChannelType type() const { return channeltype_; }
+    ChannelType type() const { return params_.staged().type; }
 	QString signalName() const { return signalName_; }
 	QString unit() const { return unit_; }
 	NumberFormat format() const { return fmt_; }
 	int digits() const { return digits_; }
-    QDaqVector range() const { return range_; }
-	AveragingType averaging() const { return type_; }
-	double forgettingFactor() const { return ff_; }
-	double offset() const { return offset_; }
-	double multiplier() const { return multiplier_; }
+    QDaqVector range() const;
+	AveragingType averaging() const { return params_.staged().averaging; }
+	double forgettingFactor() const { return params_.staged().ff; }
+	double percentile() const { return params_.staged().percentile; }
+	double offset() const { return params_.staged().offset; }
+	double multiplier() const { return params_.staged().multiplier; }
 	uint memsize() const { return buff_.capacity(); }
 	uint depth() const { return depth_; }
-	bool dataReady() const { return dataReady_; }
+	bool dataReady() const { Sample s; snapshot(s); return s.ready; }
 	QString parserExpression() const;
+    QDaqVector playbackData() const { return playback_; }
+    bool compiled() const { return compiled_; }
+    CalibrationType calibration() const { return calibType_; }
+    QDaqVector calibrationCoefficients() const { return calibCoef_; }
+    QDaqVector calibrationBreakpoints() const { return calibBreaks_; }
+    double coldJunction() const { return coldJunction_; }
 
 	// setters
     void setType(ChannelType t);
@@ -198,26 +399,75 @@ public:
 	void setMultiplier(double v);
 	void setAveraging(AveragingType t);
 	void setForgettingFactor(double v);
+	void setPercentile(double v);
 	void setDepth(uint d);
 	void setParserExpression(const QString& s);
+    void setPlaybackData(const QDaqVector& v);
+    void setCompiled(bool on);
+    void setCalibration(CalibrationType t);
+    void setCalibrationCoefficients(const QDaqVector& v);
+    void setCalibrationBreakpoints(const QDaqVector& v);
+    void setColdJunction(double t);
 
 
 	void forceProcces();
 
 	double last() const { return buff_.last(); }
 
+    /** Processed value of sample j of the last block.
+     *
+     * In block mode j runs from 0 (oldest) to QDaqLoop::blockSize - 1 (newest).
+     * If the channel is not in block mode, value() is returned.
+     */
+    double blockValue(uint j) const { return j < block_.size() ? block_[j] : v_; }
+    /** Copy the processed values of the last block to dst, as read by a job of the loop top.
+     *
+     * If the channel is armed in the same top level loop as the reader,
+     * dst[j] = blockValue(j) for j = 0 ... n-1. Otherwise, i.e. if the channel
+     * runs in another thread or is lazy (QDaqVirtualChannel), the block is
+     * filled with value(), which is read through the lock-free snapshot.
+     */
+    void blockValues(double* dst, uint n, const QDaqLoop* top) const;
+    /** Insert n values into the channel, oldest first.
+     *
+     * Same as calling push(double) for v[0], v[1], ... v[n-1].
+     */
+    void push(const double* v, uint n) { buff_.push(v,n); counter_ += n; pending_ += n; }
+
     /// Returns the channel value formatted according to format/digits
 	virtual QString formatedValue();
 
+    /** Get a consistent copy of the channel output.
+     *
+     * Can be called from any thread without locking. Returns the sequence
+     * number of the sample, which is incremented each time the channel publishes
+     * a new output.
+     */
+    uint snapshot(Sample& s) const
+    {
+        if (lazy_) const_cast<QDaqChannel*>(this)->refresh();
+        return out_.read(s);
+    }
+
 public slots:
 	/** Insert a value into the channel. */
-	void push(double v) { buff_ << v; counter_++; }
+	void push(double v) { buff_ << v; counter_++; pending_++; }
 	/** Clear internal channel memory.*/
-	void clear();
+	virtual void clear();
 	/** Get the current channel value. */
-	double value() const { return v_; }
+	double value() const { Sample s; snapshot(s); return s.value; }
 	/** Get the current channel value standard deviation. */
-	double std() const { return dv_; }
+	double std() const { Sample s; snapshot(s); return s.std; }
+	/** Get the time of the current channel value. */
+	double timestamp() const { Sample s; snapshot(s); return s.time; }
+	/** Get the sequence number of the current channel value.
+	It is incremented each time the channel output changes.
+	*/
+	uint sequence() const
+	{
+		if (lazy_) const_cast<QDaqChannel*>(this)->refresh();
+		return out_.sequence();
+	}
 };
 
 #endif // QDAQDATACHANNEL_H
@@ -0,0 +1,412 @@
+#include "QDaqChannelBank.h"
+
+#include <cmath>
+#include <algorithm>
+
+// the running sums are recomputed from the history after
+// this number of incremental updates to remove round-off drift
+#define BANK_RECOMPUTE_INTERVAL 65536
+
+// The kernels below process all channels in one loop over
+// contiguous arrays. Ask gcc to vectorize them also at -O2.
+#if defined(__GNUC__) && !defined(__clang__)
+#define BANK_KERNEL static __attribute__((optimize("tree-vectorize")))
+#else
+#define BANK_KERNEL static
+#endif
+
+// s1 += x, s2 += x^2
+BANK_KERNEL void kernelAdd(double* s1, double* s2, const double* x, uint n)
+{
+    for(uint i=0; i<n; ++i) {
+        s1[i] += x[i];
+        s2[i] += x[i]*x[i];
+    }
+}
+// s1 += x - xo, s2 += x^2 - xo^2
+BANK_KERNEL void kernelSlide(double* s1, double* s2, const double* x, const double* xo, uint n)
+{
+    for(uint i=0; i<n; ++i) {
+        s1[i] += x[i] - xo[i];
+        s2[i] += x[i]*x[i] - xo[i]*xo[i];
+    }
+}
+// s = ff*s + x - ffd*xo (xo may be 0)
+BANK_KERNEL void kernelForget(double* s1, double* s2, const double* x, const double* xo,
+                         double ff, double ffd, uint n)
+{
+    if (xo) {
+        for(uint i=0; i<n; ++i) {
+            s1[i] = ff*s1[i] + x[i] - ffd*xo[i];
+            s2[i] = ff*s2[i] + x[i]*x[i] - ffd*xo[i]*xo[i];
+        }
+    } else {
+        for(uint i=0; i<n; ++i) {
+            s1[i] = ff*s1[i] + x[i];
+            s2[i] = ff*s2[i] + x[i]*x[i];
+        }
+    }
+}
+// v = w*s1, dv = std from w*s2 = <y^2>
+BANK_KERNEL void kernelMoments(double* v, double* dv, const double* s1, const double* s2,
+                          double w, uint n)
+{
+    for(uint i=0; i<n; ++i) {
+        double m = w*s1[i];
+        double d = w*s2[i] - m*m;
+        v[i] = m;
+        dv[i] = d > 0. ? std::sqrt(d) : 0.;
+    }
+}
+// scale and clamp to range
+BANK_KERNEL void kernelScale(double* v, double* dv, const double* mul, const double* off,
+                        const double* lo, const double* hi, uint n)
+{
+    for(uint i=0; i<n; ++i) {
+        double y = mul[i]*v[i] + off[i];
+        y = y < lo[i] ? lo[i] : y;
+        y = y > hi[i] ? hi[i] : y;
+        v[i] = y;
+        dv[i] = std::fabs(mul[i])*dv[i];
+    }
+}
+
+//////////////////// QDaqBankChannel //////////////////////////////////////////
+
+QDaqBankChannel::QDaqBankChannel(const QString &name) : QDaqChannel(name)
+{
+}
+
+bool QDaqBankChannel::arm_()
+{
+    dataReady_ = false;
+    counter_ = 0;
+    block_.assign(blockSize_>1 ? blockSize_ : 0, 0.);
+    publish();
+    return QDaqJob::arm_();
+}
+
+QDaqChannelBank* QDaqBankChannel::bank() const
+{
+    return qobject_cast<QDaqChannelBank*>(parent());
+}
+
+//////////////////// QDaqChannelBank //////////////////////////////////////////
+
+QDaqChannelBank::QDaqChannelBank(const QString &name) : QDaqJob(name),
+    averaging_(QDaqChannel::None), depth_(1), ff_(0.99), count_(0),
+    xrows_(1), xhead_(0), pending_(0), head_(0), updates_(0), ffd_(0.99), ffw_(100.)
+{
+}
+
+void QDaqChannelBank::setSize(uint n)
+{
+    if (throwIfArmed()) return;
+    if (n == size()) return;
+
+    while (size() > n)
+    {
+        channel_t ch = channels_.takeLast();
+        if (ch) delete removeChild(ch);
+    }
+    while (size() < n)
+    {
+        QDaqBankChannel* ch = new QDaqBankChannel(QString("ch%1").arg(size()));
+        if (!appendChild(ch)) { delete ch; break; }
+        channels_ << ch;
+    }
+    x_.assign(size(), 0.);
+    xrows_ = 1;
+    xhead_ = 0;
+    pending_ = 0;
+
+    emit propertiesChanged();
+}
+
+void QDaqChannelBank::setAveraging(QDaqChannel::AveragingType t)
+{
+    if (throwIfArmed()) return;
+    if (t!=QDaqChannel::None && t!=QDaqChannel::Running && t!=QDaqChannel::ForgettingFactor)
+    {
+        throwScriptError("Invalid averaging specification. Availiable options: "
+                         "None, Running, ForgettingFactor");
+        return;
+    }
+    if (averaging_ != t)
+    {
+        averaging_ = t;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqChannelBank::setDepth(uint d)
+{
+    if (throwIfArmed()) return;
+    if (d>0 && d!=depth_)
+    {
+        depth_ = d;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqChannelBank::setForgettingFactor(double v)
+{
+    if (throwIfArmed()) return;
+    if (v!=ff_ && v>0. && v<1.)
+    {
+        ff_ = v;
+        emit propertiesChanged();
+    }
+}
+
+QDaqChannel* QDaqChannelBank::channel(uint i) const
+{
+    return i < size() ? channels_.at(i).data() : 0;
+}
+
+QDaqVector QDaqChannelBank::values() const
+{
+    QDaqVector v;
+    foreach(const channel_t& ch, channels_)
+        v << (ch ? ch->value() : 0.);
+    return v;
+}
+
+void QDaqChannelBank::pushScan(const double *x, uint n)
+{
+    const uint N = size();
+    if (!N) return;
+    if (n > N) n = N;
+    double* row = &x_[xhead_*N];
+    // the remaining channels keep their previous input
+    if (n < N && xrows_ > 1)
+    {
+        const double* prev = &x_[((xhead_ + xrows_ - 1) % xrows_)*N];
+        std::copy(prev + n, prev + N, row + n);
+    }
+    std::copy(x, x + n, row);
+    xhead_ = (xhead_ + 1) % xrows_;
+    if (pending_ < xrows_) pending_++;
+}
+
+void QDaqChannelBank::push(const QDaqVector &v)
+{
+    JobLocker L(this);
+    pushScan(v.constData(), v.size());
+}
+
+bool QDaqChannelBank::arm_()
+{
+    // gather the channel settings
+    uint n = size();
+    mul_.assign(n,1.); off_.assign(n,0.);
+    lo_.assign(n,-1e30); hi_.assign(n,1e30);
+    ptrs_.assign(n,0);
+    for(uint i=0; i<n; ++i)
+    {
+        QDaqBankChannel* ch = channels_.at(i);
+        if (!ch) continue;
+        ptrs_[i] = ch;
+        mul_[i] = ch->multiplier();
+        off_[i] = ch->offset();
+        QDaqVector r = ch->range();
+        lo_[i] = r[0]; hi_[i] = r[1];
+        // the channels are updated by the bank, not executed as jobs
+        subjobs_.removeAll(ch);
+    }
+
+    v_.assign(n,0.); dv_.assign(n,0.);
+    s1_.assign(n,0.); s2_.assign(n,0.);
+    hist_.assign(depth_*n,0.);
+    // room for one block of scans, starting from the latest input
+    std::vector<double> last(n, 0.);
+    if (n && x_.size() == (size_t)xrows_*n)
+    {
+        const double* prev = &x_[((xhead_ + xrows_ - 1) % xrows_)*n];
+        std::copy(prev, prev + n, last.begin());
+    }
+    xrows_ = blockSize_>1 ? blockSize_ : 1;
+    x_.assign(xrows_*n, 0.);
+    std::copy(last.begin(), last.end(), x_.end() - n);
+    xhead_ = 0;
+    pending_ = 0;
+    head_ = 0;
+    updates_ = 0;
+    count_ = 0;
+    ffd_ = pow(ff_,(int)depth_);
+    ffw_ = 1./(1. - ffd_);
+
+    return QDaqJob::arm_();
+}
+
+void QDaqChannelBank::disarm_()
+{
+    QDaqJob::disarm_();
+    foreach(QDaqBankChannel* ch, ptrs_)
+        if (ch) ch->setArmed(false);
+    ptrs_.clear();
+}
+
+void QDaqChannelBank::recomputeSums(uint m)
+{
+    uint n = size();
+    std::fill(s1_.begin(), s1_.end(), 0.);
+    std::fill(s2_.begin(), s2_.end(), 0.);
+    // the newest row is head_-1, weights ff^j for the j-th newest
+    double w = 1.;
+    for(uint j=0; j<m; ++j)
+    {
+        const double* row = &hist_[((head_ + depth_ - 1 - j) % depth_)*n];
+        if (averaging_==QDaqChannel::ForgettingFactor)
+        {
+            for(uint i=0; i<n; ++i) {
+                s1_[i] += w*row[i];
+                s2_[i] += w*row[i]*row[i];
+            }
+            w *= ff_;
+        }
+        else kernelAdd(s1_.data(), s2_.data(), row, n);
+    }
+    updates_ = 0;
+}
+
+void QDaqChannelBank::adoptScaling()
+{
+    uint n = size();
+    for(uint i=0; i<n; ++i)
+    {
+        QDaqBankChannel* ch = ptrs_[i];
+        if (!ch || !ch->params_.adopt()) continue;
+        const QDaqBankChannel::params_t& p = ch->params_.current();
+        mul_[i] = p.multiplier;
+        off_[i] = p.offset;
+        lo_[i] = p.range[0];
+        hi_[i] = p.range[1];
+    }
+}
+
+void QDaqChannelBank::processScan(const double* x)
+{
+    uint n = size();
+    count_++;
+    uint m = count_ < depth_ ? count_ : depth_;
+    bool full = count_ > depth_;
+    double* row = &hist_[head_*n]; // the oldest scan, replaced by x
+
+    switch(averaging_)
+    {
+    case QDaqChannel::Running:
+        if (full) kernelSlide(s1_.data(), s2_.data(), x, row, n);
+        else kernelAdd(s1_.data(), s2_.data(), x, n);
+        break;
+    case QDaqChannel::ForgettingFactor:
+        kernelForget(s1_.data(), s2_.data(), x, full ? row : 0, ff_, ffd_, n);
+        break;
+    default:
+        break;
+    }
+    std::copy(x, x + n, row);
+    head_ = (head_ + 1) % depth_;
+    updates_++;
+
+    if (averaging_!=QDaqChannel::None && updates_ >= BANK_RECOMPUTE_INTERVAL)
+        recomputeSums(m);
+
+    switch(averaging_)
+    {
+    case QDaqChannel::Running:
+        kernelMoments(v_.data(), dv_.data(), s1_.data(), s2_.data(), 1./m, n);
+        break;
+    case QDaqChannel::ForgettingFactor:
+        kernelMoments(v_.data(), dv_.data(), s1_.data(), s2_.data(), (1-ff_)*ffw_, n);
+        break;
+    default:
+        std::copy(x, x + n, v_.begin());
+        std::fill(dv_.begin(), dv_.end(), 0.);
+        break;
+    }
+
+    kernelScale(v_.data(), dv_.data(), mul_.data(), off_.data(), lo_.data(), hi_.data(), n);
+}
+
+void QDaqChannelBank::updateChannels(uint nscans)
+{
+    uint n = size();
+    for(uint i=0; i<n; ++i)
+    {
+        QDaqBankChannel* ch = ptrs_[i];
+        if (!ch) continue;
+        ch->v_ = v_[i];
+        ch->dv_ = dv_[i];
+        ch->dataReady_ = std::isfinite(v_[i]);
+        ch->counter_ += nscans;
+        ch->publish();
+    }
+
+    // the channel widgets are updated from deliverNotifications()
+    notify(NotifyWidgets);
+}
+
+bool QDaqChannelBank::run()
+{
+    if (!QDaqJob::run()) return false;
+    if (!pending_) return true;
+    pending_ = 0;
+
+    uint n = size();
+    if (!n) return true;
+
+    adoptScaling();
+    // the latest scan
+    processScan(&x_[((xhead_ + xrows_ - 1) % xrows_)*n]);
+    updateChannels(1);
+
+    return true;
+}
+
+bool QDaqChannelBank::runBlock(uint n)
+{
+    if (!QDaqJob::run()) return false;
+
+    uint N = size();
+    if (!N) return true;
+
+    adoptScaling();
+
+    // process the pending scans from the oldest to the newest
+    uint m = pending_ < n ? pending_ : n;
+    pending_ = 0;
+    uint r = (xhead_ + xrows_ - m) % xrows_;
+    for(uint k=0; k<m; ++k)
+    {
+        processScan(&x_[r*N]);
+        r = (r + 1) % xrows_;
+        uint j = n - m + k;
+        for(uint i=0; i<N; ++i)
+            if (ptrs_[i]) ptrs_[i]->block_[j] = v_[i];
+    }
+
+    // missing entries at the start of the block repeat the first result,
+    // or the current value if there was no new scan
+    for(uint i=0; i<N; ++i)
+    {
+        QDaqBankChannel* ch = ptrs_[i];
+        if (!ch) continue;
+        double* b = ch->block_.data();
+        std::fill(b, b + (n - m), m ? b[n-m] : ch->v_);
+    }
+
+    if (m) updateChannels(m);
+
+    return true;
+}
+
+void QDaqChannelBank::deliverNotifications(int flags)
+{
+    QDaqJob::deliverNotifications(flags);
+    if (flags & NotifyWidgets)
+    {
+        foreach(const channel_t& ch, channels_)
+            if (ch) emit ch->updateWidgets();
+    }
+}
@@ -0,0 +1,178 @@
+#ifndef QDAQCHANNELBANK_H
+#define QDAQCHANNELBANK_H
+
+#include "QDaqChannel.h"
+
+#include <QPointer>
+#include <vector>
+
+class QDaqChannelBank;
+
+/**
+ * @brief A channel of a QDaqChannelBank.
+ *
+ * @ingroup Core
+ * @ingroup ScriptAPI
+ *
+ * A lightweight QDaqChannel that is created by a QDaqChannelBank as its child.
+ * It does not process data itself; its value, std and dataReady are set by the
+ * bank at each repetition. Thus it can be used wherever a QDaqChannel is
+ * expected, e.g., in a QDaqDataBuffer or a widget.
+ *
+ * The multiplier, offset and range of each bank channel are used by the bank.
+ * They can be changed at any time; the bank adopts them at the next
+ * repetition. All other processing properties (type, averaging,
+ * parserExpression, etc.) have no effect.
+ *
+ */
+class QDAQ_EXPORT QDaqBankChannel : public QDaqChannel
+{
+    Q_OBJECT
+
+protected:
+    // no processing buffers needed
+    virtual bool arm_();
+    // the bank does the processing
+    virtual bool run() { return true; }
+
+    friend class QDaqChannelBank;
+
+public:
+    explicit QDaqBankChannel(const QString& name);
+
+    /// The bank that this channel belongs to.
+    QDaqChannelBank* bank() const;
+};
+
+/**
+ * @brief A bank of channels processed together.
+ *
+ * @ingroup Core
+ * @ingroup ScriptAPI
+ *
+ * QDaqChannelBank holds size logical channels, e.g. the inputs of a
+ * multi-channel ADC. The data of all channels are stored in
+ * struct-of-arrays form and each processing stage (averaging, scaling,
+ * range check) is applied to all channels in one loop, which the compiler
+ * vectorizes.
+ *
+ * Each channel is represented by a QDaqBankChannel child object, named ch0, ch1, ...,
+ * which can be used by scripts, widgets and QDaqDataBuffer as a normal channel.
+ *
+ * A scan of all channels is inserted with push() (from script code, e.g.
+ * the runCode of the bank) or pushScan() (from C++ code running
+ * in the loop thread, before the bank). At each repetition where a new scan
+ * is available, the bank processes it and updates its channels.
+ *
+ * In block mode (QDaqLoop::blockSize > 1) up to blockSize scans can be
+ * inserted per repetition. They are processed in the order they were
+ * inserted and fill the blocks of the bank channels, as in
+ * QDaqChannel::runBlock(). If more scans are inserted only the latest
+ * blockSize are kept.
+ *
+ * Averaging is common to all channels. The types None, Running and
+ * ForgettingFactor are supported with the same definitions as in QDaqChannel.
+ *
+ */
+class QDAQ_EXPORT QDaqChannelBank : public QDaqJob
+{
+    Q_OBJECT
+
+    /// Number of channels. It cannot be changed while the bank is armed.
+    Q_PROPERTY(uint size READ size WRITE setSize)
+    /// Type of averaging, None, Running or ForgettingFactor.
+    Q_PROPERTY(QDaqChannel::AveragingType averaging READ averaging WRITE setAveraging)
+    /// Averaging depth.
+    Q_PROPERTY(uint depth READ depth WRITE setDepth)
+    /// Forgetting factor value, used for ForgettingFactor averaging.
+    Q_PROPERTY(double forgettingFactor READ forgettingFactor WRITE setForgettingFactor)
+    /// Number of scans processed since the bank was armed (read-only).
+    Q_PROPERTY(uint count READ count)
+
+protected:
+    typedef QPointer<QDaqBankChannel> channel_t;
+    QList<channel_t> channels_;
+
+    QDaqChannel::AveragingType averaging_;
+    uint depth_;
+    double ff_;
+    uint count_;
+
+    // scans not yet processed, a ring of max(blockSize,1) rows of size()
+    std::vector<double> x_;
+    uint xrows_, xhead_; // rows of x_, row to be written next
+    uint pending_; // number of scans in x_
+
+    // per-channel arrays, set up when armed
+    std::vector<double> mul_, off_, lo_, hi_; // scaling and range
+    std::vector<double> v_, dv_; // results
+    std::vector<double> s1_, s2_; // running sums
+    std::vector<double> hist_; // past scans, depth_ rows of size()
+    uint head_; // row of hist_ to be overwritten next
+    uint updates_; // incremental updates since the sums were recomputed
+    double ffd_, ffw_; // ff^depth, 1/(1-ff^depth)
+    std::vector<QDaqBankChannel*> ptrs_; // the channels while armed
+
+    // recompute the running sums from hist_
+    void recomputeSums(uint m);
+    // adopt the multiplier, offset and range of the channels
+    void adoptScaling();
+    // average and scale the scan x into v_, dv_
+    void processScan(const double* x);
+    // copy the results to the channels
+    void updateChannels(uint nscans);
+
+    virtual bool arm_();
+    virtual void disarm_();
+    /**
+     * @brief Process the latest scan.
+     *
+     * Runs the script code (if any), which may push a new scan. If a new
+     * scan is available it is averaged, scaled and clamped to range, and
+     * the results are copied to the bank channels.
+     */
+    virtual bool run();
+    /**
+     * @brief Process the scans inserted in this repetition.
+     *
+     * Runs the script code (if any) once, then processes the pending scans
+     * in the order they were inserted. The results of scan j fill entry j of
+     * the channel blocks; missing entries at the start of the block repeat
+     * the first result.
+     */
+    virtual bool runBlock(uint n);
+    virtual void deliverNotifications(int flags);
+
+public:
+    Q_INVOKABLE explicit QDaqChannelBank(const QString& name);
+
+    uint size() const { return channels_.size(); }
+    QDaqChannel::AveragingType averaging() const { return averaging_; }
+    uint depth() const { return depth_; }
+    double forgettingFactor() const { return ff_; }
+    uint count() const { return count_; }
+
+    void setSize(uint n);
+    void setAveraging(QDaqChannel::AveragingType t);
+    void setDepth(uint d);
+    void setForgettingFactor(double v);
+
+    /**
+     * @brief Insert a scan of n values, one per channel.
+     *
+     * Must be called from the loop thread, before the bank is executed.
+     * If n is less than size() the remaining channels keep their previous input.
+     * In block mode it can be called up to blockSize times per repetition.
+     */
+    void pushScan(const double* x, uint n);
+
+public slots:
+    /// Insert a scan, a vector with one value per channel.
+    void push(const QDaqVector& v);
+    /// Return the channel i.
+    QDaqChannel* channel(uint i) const;
+    /// Return the current values of all channels.
+    QDaqVector values() const;
+};
+
+#endif // QDAQCHANNELBANK_H
@@ -2,14 +2,16 @@
 #include "QDaqChannel.h"
 
 #include <QCoreApplication>
-#include <QVariant>
+#include <QVariant>
+
+#include <algorithm>
 
 QDaqDataBuffer::QDaqDataBuffer(const QString &name) : QDaqJob(name)
 {
     connect(this,SIGNAL(dataReady()),this,SLOT(onDataReady()),Qt::QueuedConnection);
 
     circular_ = false;
-    setBackBufferDepth(2);
+    setBackBufferDepth(16);
     setCapacity(100);
 
 }
@@ -18,7 +20,7 @@ void QDaqDataBuffer::setBackBufferDepth(uint d)
 {
     if (d>0)
 	{
-        QMutexLocker L(&comm_lock);
+        JobLocker L(this);
 
         // depth should be power of 2
         uint n = 1;
@@ -62,7 +64,7 @@ void QDaqDataBuffer::setupBackBuffer()
 void QDaqDataBuffer::removeChannels(QDaqObjectList chlist)
 {
 
-    QMutexLocker L(&comm_lock);
+    JobLocker L(this);
     int k;
     foreach(QDaqObject* obj, chlist)
     {
@@ -116,7 +118,7 @@ void QDaqDataBuffer::addChannels(QDaqObjectList chlist)
 // add exhaustive checks: names', properties' clashes, If empty previous chlist, create it
 // ...
 
-     QMutexLocker L(&comm_lock);
+     JobLocker L(this);
 
      // append channel objects
     channel_objects.append(chlist);
@@ -174,7 +176,7 @@ void QDaqDataBuffer::setChannels(QDaqObjectList chlist)
 		}
 	}
 
-    QMutexLocker L(&comm_lock);
+    JobLocker L(this);
 
 	// clear previous channels
 	channel_objects.clear();
@@ -215,7 +217,7 @@ void QDaqDataBuffer::setChannels(QDaqObjectList chlist)
 
 void QDaqDataBuffer::setColumnNames(QStringList collist)
 {
-    QMutexLocker L(&comm_lock);
+    JobLocker L(this);
 
     // clear previous channels & columns
     channel_objects.clear();
@@ -252,22 +254,25 @@ bool QDaqDataBuffer::run()
 {
 
 
-    if (freePackets_.tryAcquire())
+    if (acquirePacket())
     {
         double* p = backPackets_[iFree_ % backBufferDepth_];
         iFree_++;
 
 
+        QDaqChannel::Sample s;
         for(int i=0; i<channel_ptrs.size(); i++)
         {
             channel_t ch = channel_ptrs[i];
             *p = 0.;
-            if (ch && ch->dataReady()) *p = ch->value();
+            if (ch) {
+                ch->snapshot(s);
+                if (s.ready) *p = s.value;
+            }
             p++;
         }
 
-        usedPackets_.release();
-        emit dataReady();
+        releasePackets(1);
 
     }
     else
@@ -279,9 +284,70 @@ bool QDaqDataBuffer::run()
 
     return QDaqJob::run();
 }
+bool QDaqDataBuffer::runBlock(uint n)
+{
+    // get the channel blocks
+    const int m = channel_ptrs.size();
+    if (blockIn_.size() < (size_t)m*n) blockIn_.resize(m*n);
+    for(int i=0; i<m; i++)
+    {
+        channel_t ch = channel_ptrs[i];
+        double* b = blockIn_.data() + i*n;
+        if (ch && ch->dataReady()) ch->blockValues(b, n, top_);
+        else std::fill(b, b + n, 0.);
+    }
+
+    uint k = 0;
+    while(k<n && acquirePacket())
+    {
+        double* p = backPackets_[iFree_ % backBufferDepth_];
+        iFree_++;
+
+        for(int i=0; i<m; i++) *p++ = blockIn_[i*n + k];
+        k++;
+    }
+
+    // hand the whole block over at once
+    if (k) releasePackets(k);
+    if (k<n) pushError("Back-buffer full - data lost.");
+
+    return QDaqJob::run();
+}
+bool QDaqDataBuffer::acquirePacket()
+{
+    if (freePackets_.tryAcquire()) return true;
+    // a loop in virtual time runs faster than the main thread
+    // collects data. Wait instead of losing packets.
+    return top_ && top_->virtualTime() && !top_->stopping() &&
+            freePackets_.tryAcquire(1,1000);
+}
+void QDaqDataBuffer::releasePackets(uint n)
+{
+    usedPackets_.release(n);
+    // normally the packets are collected with the next notification.
+    // Posting a signal allocates, do it only if the back buffer is filling up.
+    if (usedPackets_.available() > int(backBufferDepth_/2))
+    {
+        if (!signalPending_.fetchAndStoreAcquire(1)) emit dataReady();
+    }
+    else notify(NotifyData);
+}
+void QDaqDataBuffer::deliverNotifications(int flags)
+{
+    if (flags & NotifyData) onDataReady();
+    QDaqJob::deliverNotifications(flags);
+}
+bool QDaqDataBuffer::arm_()
+{
+    // room for at least 2 blocks
+    if (backBufferDepth_ < 2*blockSize_) setBackBufferDepth(2*blockSize_);
+    blockIn_.assign(channel_ptrs.size()*blockSize_, 0.);
+    return QDaqJob::arm_();
+}
 void QDaqDataBuffer::onDataReady()
 {
     // get real-time data in
+    signalPending_.storeRelease(0);
 
     int nread = 0;
     // locked code
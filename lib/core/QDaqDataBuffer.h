@@ -7,6 +7,8 @@
 #include <QPointer>
 #include <QSemaphore>
 
+#include <vector>
+
 class QDaqChannel;
 
 /**
@@ -24,7 +26,10 @@ class QDaqChannel;
  * QDaqDataBuffer has an internal back buffer, where data generated in the loop
  * thread are initially stored. The data is later transferred to the main buffer
  * whenever possible and becomes available to the main application thread.
- * The process is marshalled internally by a semaphore and the Qt signal/slot mechanism.
+ * The process is marshalled internally by a semaphore. The data are normally
+ * collected when the root object delivers notifications (QDaqObject::notify()),
+ * thus the loop thread does not post an event at each repetition. Only when
+ * the back buffer becomes half full, the main thread is signalled immediately.
  * Increasing the size of the back buffer can prevent data loss in fast loops.
  *
  * The QDaqDataBuffer may be also used as a static object outside of a loop.
@@ -35,7 +40,7 @@ class QDAQ_EXPORT QDaqDataBuffer : public QDaqJob
 {
 	Q_OBJECT
 
-    /// Size of the back buffer in rows.
+    /// Size of the back buffer in rows (default 16).
 	Q_PROPERTY(uint backBufferDepth READ backBufferDepth WRITE setBackBufferDepth)
     /// Total capacity (allocated memory) of the data buffer in rows.
 	Q_PROPERTY(uint capacity READ capacity WRITE setCapacity)
@@ -74,7 +79,9 @@ protected:
     // back buffer   
     QVector<double> backBuffer_; // memory buffer
     QVector<double*> backPackets_; // packets
+    std::vector<double> blockIn_; // channel blocks, one after the other
     QSemaphore freePackets_, usedPackets_; // used for marshalling the packets
+    QAtomicInt signalPending_; // a dataReady signal has not been handled yet
     uint iFree_, iUsed_; // index of free and used packets
     void setupBackBuffer();
 
@@ -93,6 +100,16 @@ protected:
      *
      */
     virtual bool run();
+    // writes one row per sample of the channel blocks
+    virtual bool runBlock(uint n);
+    virtual bool arm_();
+    // get a free packet. In virtualTime mode wait for the main thread.
+    bool acquirePacket();
+    // hand n filled packets over to the main thread
+    void releasePackets(uint n);
+
+    enum { NotifyData = NotifyUser };
+    virtual void deliverNotifications(int flags);
 
     //void resize();
 
@@ -116,7 +133,7 @@ public:
     void setColumnNames(QStringList collist);
 
 signals:
-    // emitted when a data packet becomes available
+    // emitted when the back buffer fills up
     void dataReady();
 
 private slots:
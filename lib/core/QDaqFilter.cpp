@@ -86,7 +86,7 @@ bool QDaqFilter::run()
         }
     }
 
-    bool ret = filterfunc(inbuff.constData(), outbuff.data());
+    bool ret = filterblock(inbuff.constData(), outbuff.data(), 1);
     if (!ret) return false;
 
     // push output values
@@ -103,6 +103,53 @@ bool QDaqFilter::run()
     return QDaqJob::run();
 }
 
+bool QDaqFilter::runBlock(uint n)
+{
+    if (n > blockSize_) n = blockSize_;
+
+    // get the input blocks
+    for(int i=0; i<inputChannels_.size(); i++)
+    {
+        QDaqChannel* ch = inputChannels_[i];
+        if (ch) ch->blockValues(inblock_.data() + i*n, n, top_);
+        else{
+            pushError("Input channel lost.");
+            return false;
+        }
+    }
+
+    bool ret = filterblock(inblock_.data(), outblock_.data(), n);
+    if (!ret) return false;
+
+    // push the output blocks
+    for(int i=0; i<outputChannels_.size(); i++)
+    {
+        QDaqChannel* ch = outputChannels_[i];
+        if (ch) ch->push(outblock_.data() + i*n, n);
+        else{
+            pushError("Output channel lost.");
+            return false;
+        }
+    }
+
+    return QDaqJob::run();
+}
+
+bool QDaqFilter::filterblock(const double* in, double* out, int n)
+{
+    if (n==1) return filterfunc(in, out);
+
+    // one sample at a time
+    int ni = inputChannels_.size(), no = outputChannels_.size();
+    for(int j=0; j<n; ++j)
+    {
+        for(int i=0; i<ni; i++) inbuff[i] = in[i*n + j];
+        if (!filterfunc(inbuff.constData(), outbuff.data())) return false;
+        for(int k=0; k<no; k++) out[k*n + j] = outbuff[k];
+    }
+    return true;
+}
+
 bool QDaqFilter::arm_()
 {
     if (nInputChannels() != inputChannels_.size())
@@ -119,6 +166,8 @@ bool QDaqFilter::arm_()
 
     inbuff.setCapacity(inputChannels_.size());
     outbuff.setCapacity(outputChannels_.size());
+    inblock_.assign(inputChannels_.size()*blockSize_, 0.);
+    outblock_.assign(outputChannels_.size()*blockSize_, 0.);
 
     if (!filterinit()) return false;
 
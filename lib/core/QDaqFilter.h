@@ -5,6 +5,7 @@
 #include "QDaqVector.h"
 
 #include <QPointer>
+#include <vector>
 
 class QDaqChannel;
 
@@ -27,6 +28,8 @@ class QDAQ_EXPORT QDaqFilter : public QDaqJob
 
     channel_vector_t inputChannels_, outputChannels_;
     QDaqVector inbuff, outbuff;
+    // input/output blocks for filterblock(), one row of blockSize per channel
+    std::vector<double> inblock_, outblock_;
 
 public:    
     explicit QDaqFilter(const QString& name);
@@ -44,14 +47,37 @@ public:
 protected:
     virtual bool arm_();
     virtual bool run();
+    // moves whole blocks from the input channels through filterblock()
+    // to the output channels
+    virtual bool runBlock(uint n);
 
     virtual bool filterinit() = 0; // { return false; }
-    virtual bool filterfunc(const double* in, double* out) = 0;
-    /*{
+    /**
+     * @brief Process one sample.
+     *
+     * in[i] is the value of input channel i, out[k] receives the value
+     * for output channel k. Returns false on error.
+     *
+     * A filter must reimplement filterfunc() or filterblock().
+     */
+    virtual bool filterfunc(const double* in, double* out)
+    {
         Q_UNUSED(in);
         Q_UNUSED(out);
         return false;
-    }*/
+    }
+    /**
+     * @brief Process a block of n samples.
+     *
+     * in[i*n + j] is sample j (oldest first) of input channel i and
+     * out[k*n + j] receives sample j of output channel k. Returns false on error.
+     *
+     * In block mode it is called once per repetition with n = QDaqLoop::blockSize,
+     * otherwise with n = 1. The default implementation calls filterfunc()
+     * for each sample. Filters may reimplement it to process the samples
+     * of each channel in a tight (vectorizable) loop.
+     */
+    virtual bool filterblock(const double* in, double* out, int n);
 
 };
 
@@ -0,0 +1,211 @@
+#include "QDaqGenerator.h"
+
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+QDaqGenerator::QDaqGenerator(const QString &name) : QDaqChannel(name),
+    seed_(0),
+    t0Ns_(0), started_(false), tlast_(0.), walk_(0.)
+{
+    {
+        os::published<waveform_t>::editor p(wave_);
+        p->waveform = Sine;
+        p->amplitude = 1.;
+        p->frequency = 1.;
+        p->frequency2 = 10.;
+        p->sweepTime = 1.;
+        p->noise = 0.;
+        p->drift = 0.;
+    }
+    w_ = wave_.staged();
+}
+
+void QDaqGenerator::setWaveform(Waveform w)
+{
+    if ((int)w==-1)
+    {
+        throwScriptError("Invalid waveform specification. Availiable options: "
+                         "Uniform, Gaussian, Sine, Square, Chirp");
+        return;
+    }
+    if (waveform() != w)
+    {
+        {
+            os::published<waveform_t>::editor p(wave_);
+            p->waveform = w;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqGenerator::setAmplitude(double v)
+{
+    if (amplitude() != v)
+    {
+        {
+            os::published<waveform_t>::editor p(wave_);
+            p->amplitude = v;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqGenerator::setFrequency(double v)
+{
+    if (frequency() != v && v >= 0.)
+    {
+        {
+            os::published<waveform_t>::editor p(wave_);
+            p->frequency = v;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqGenerator::setFrequency2(double v)
+{
+    if (frequency2() != v && v >= 0.)
+    {
+        {
+            os::published<waveform_t>::editor p(wave_);
+            p->frequency2 = v;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqGenerator::setSweepTime(double v)
+{
+    if (sweepTime() != v && v > 0.)
+    {
+        {
+            os::published<waveform_t>::editor p(wave_);
+            p->sweepTime = v;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqGenerator::setNoise(double v)
+{
+    if (noise() != v && v >= 0.)
+    {
+        {
+            os::published<waveform_t>::editor p(wave_);
+            p->noise = v;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqGenerator::setDrift(double v)
+{
+    if (drift() != v && v >= 0.)
+    {
+        {
+            os::published<waveform_t>::editor p(wave_);
+            p->drift = v;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqGenerator::setSeed(uint s)
+{
+    if (throwIfArmed()) return;
+    if (seed_ != s)
+    {
+        seed_ = s;
+        emit propertiesChanged();
+    }
+}
+
+bool QDaqGenerator::arm_()
+{
+    wave_.adopt();
+    w_ = wave_.current();
+    rng_.setSeed(seed_ ? seed_ : randomSeed());
+    started_ = false;
+    tlast_ = 0.;
+    walk_ = 0.;
+    uint n = blockSize_ > 1 ? blockSize_ : 1;
+    tbuf_.assign(n, 0.);
+    ybuf_.assign(n, 0.);
+    return QDaqChannel::arm_();
+}
+
+bool QDaqGenerator::generate(uint n)
+{
+    if (wave_.adopt()) w_ = wave_.current();
+
+    if (n > tbuf_.size()) n = tbuf_.size();
+    if (!started_)
+    {
+        t0Ns_ = sampleTimeNs(n-1);
+        started_ = true;
+    }
+
+    // sample times from the oldest to the newest
+    double* t = tbuf_.data();
+    double* y = ybuf_.data();
+    for(uint i=0; i<n; ++i) t[i] = 1e-9*(sampleTimeNs(n-1-i) - t0Ns_);
+
+    const double A = w_.amplitude;
+    switch(w_.waveform)
+    {
+    case Uniform:
+        for(uint i=0; i<n; ++i) y[i] = A*rng_.uniform();
+        break;
+    case Gaussian:
+        for(uint i=0; i<n; ++i) y[i] = A*rng_.gaussian();
+        break;
+    case Sine:
+    {
+        const double w = 2*M_PI*w_.frequency;
+        for(uint i=0; i<n; ++i) y[i] = A*std::sin(w*t[i]);
+        break;
+    }
+    case Square:
+    {
+        const double f = w_.frequency;
+        for(uint i=0; i<n; ++i) {
+            double c = f*t[i];
+            c -= std::floor(c);
+            y[i] = c < 0.5 ? A : -A;
+        }
+        break;
+    }
+    case Chirp:
+    {
+        // phase = 2pi (f1 tau + (f2-f1) tau^2 / 2T), tau = t mod T
+        const double T = w_.sweepTime;
+        const double f1 = w_.frequency;
+        const double k = 0.5*(w_.frequency2 - w_.frequency)/T;
+        for(uint i=0; i<n; ++i) {
+            double tau = t[i] - T*std::floor(t[i]/T);
+            y[i] = A*std::sin(2*M_PI*tau*(f1 + k*tau));
+        }
+        break;
+    }
+    }
+
+    if (w_.noise > 0.)
+        for(uint i=0; i<n; ++i) y[i] += w_.noise*rng_.gaussian();
+
+    if (w_.drift > 0.)
+    {
+        for(uint i=0; i<n; ++i) {
+            double dt = t[i] - tlast_;
+            if (dt > 0.) walk_ += w_.drift*std::sqrt(dt)*rng_.gaussian();
+            tlast_ = t[i];
+            y[i] += walk_;
+        }
+    }
+
+    push(y, n);
+
+    return true;
+}
@@ -0,0 +1,121 @@
+#ifndef QDAQGENERATOR_H
+#define QDAQGENERATOR_H
+
+#include "QDaqChannel.h"
+#include "os_util.h"
+
+#include <vector>
+
+/**
+ * @brief A channel that generates a synthetic signal.
+ *
+ * @ingroup Core
+ * @ingroup ScriptAPI
+ *
+ * QDaqGenerator produces test signals without hardware, e.g., for
+ * developing or load-testing acquisition pipelines. At each repetition
+ * (or for each sample in block mode) a new value of the selected
+ * waveform is inserted and then processed as in any QDaqChannel
+ * (averaging, parserExpression, multiplier/offset, range).
+ *
+ * The waveform is a function of the sample time (QDaqJob::sampleTime)
+ * counted from the first repetition after the channel is armed,
+ * thus in virtualTime loops the generated signal is exactly reproducible.
+ * Gaussian noise and a random-walk drift can be added to any waveform.
+ *
+ * Each generator has its own random number generator (math::xoshiro256),
+ * so generators in different loops do not interfere. If seed is 0 a new
+ * seed is drawn each time the channel is armed, otherwise the
+ * sequence is the same in every run.
+ *
+ * In block mode the whole block is computed in one pass over
+ * an array of sample times.
+ *
+ * The waveform parameters can be changed while the loop runs. They are
+ * published lock-free and adopted at the next repetition.
+ *
+ */
+class QDAQ_EXPORT QDaqGenerator : public QDaqChannel
+{
+    Q_OBJECT
+
+    /// Type of the generated waveform.
+    Q_PROPERTY(Waveform waveform READ waveform WRITE setWaveform)
+    /** Amplitude of the waveform.
+     * For Uniform the values are in [0, amplitude), for Gaussian amplitude
+     * is the standard deviation.
+     */
+    Q_PROPERTY(double amplitude READ amplitude WRITE setAmplitude)
+    /// Frequency in Hz of Sine and Square, start frequency of Chirp.
+    Q_PROPERTY(double frequency READ frequency WRITE setFrequency)
+    /// End frequency in Hz of Chirp.
+    Q_PROPERTY(double frequency2 READ frequency2 WRITE setFrequency2)
+    /// Duration in s of a Chirp sweep. The sweep is repeated.
+    Q_PROPERTY(double sweepTime READ sweepTime WRITE setSweepTime)
+    /// Standard deviation of gaussian noise added to the waveform.
+    Q_PROPERTY(double noise READ noise WRITE setNoise)
+    /** Random-walk drift added to the waveform.
+     * Standard deviation of the drift after 1 s.
+     */
+    Q_PROPERTY(double drift READ drift WRITE setDrift)
+    /// Random number generator seed. If 0, a new seed is used each time the channel is armed.
+    Q_PROPERTY(uint seed READ seed WRITE setSeed)
+
+public:
+    /** Type of waveform.
+    */
+    enum Waveform {
+        Uniform, /**< Uniformly distributed random values. */
+        Gaussian, /**< Normally distributed random values. */
+        Sine, /**< Sine wave. */
+        Square, /**< Square wave of 50% duty cycle. */
+        Chirp /**< Sine wave with frequency sweeping linearly from frequency to frequency2. */
+    };
+    Q_ENUM(Waveform)
+
+protected:
+    // Waveform parameters, setters write the staged copy,
+    // generate() adopts it
+    struct waveform_t {
+        Waveform waveform;
+        double amplitude, frequency, frequency2, sweepTime, noise, drift;
+    };
+    os::published<waveform_t> wave_;
+    // parameters in use by the loop thread
+    waveform_t w_;
+    uint seed_;
+
+    // time origin, sample time of the first generated sample (ns)
+    qint64 t0Ns_;
+    bool started_;
+    // time of the last sample (s from t0Ns_) and random-walk value
+    double tlast_, walk_;
+    // sample times and values of a block
+    std::vector<double> tbuf_, ybuf_;
+
+    virtual bool arm_();
+    virtual bool generate(uint n);
+
+public:
+    Q_INVOKABLE explicit QDaqGenerator(const QString& name);
+
+    Waveform waveform() const { return wave_.staged().waveform; }
+    double amplitude() const { return wave_.staged().amplitude; }
+    double frequency() const { return wave_.staged().frequency; }
+    double frequency2() const { return wave_.staged().frequency2; }
+    double sweepTime() const { return wave_.staged().sweepTime; }
+    double noise() const { return wave_.staged().noise; }
+    double drift() const { return wave_.staged().drift; }
+    uint seed() const { return seed_; }
+
+    void setWaveform(Waveform w);
+    void setAmplitude(double v);
+    void setFrequency(double v);
+    void setFrequency2(double v);
+    void setSweepTime(double v);
+    void setNoise(double v);
+    void setDrift(double v);
+    void setSeed(uint s);
+};
+
+#endif // QDAQGENERATOR_H
@@ -1,9 +1,18 @@
 #include "QDaqJob.h"
 #include "QDaqSession.h"
 #include "QDaqRoot.h"
+#include "QDaqTypes.h"
+#include "qdaqloopscheduler.h"
+#include "allocdiag.h"
+
+// the innermost executing job with a time budget, per thread
+static thread_local QDaqJob* currentBudget_ = 0;
 
 QDaqJob::QDaqJob(const QString& name) :
-    QDaqObject(name), armed_(0), program_(0), isLoop_(false)
+    QDaqObject(name), armed_(0), program_(0), isLoop_(false), blockSize_(1),
+    top_(0), budget_(0), overrunPolicy_(Flag), overruns_(0),
+    skipLeft_(0), backoff_(1), skipped_(0), deadline_(0),
+    outerBudget_(0), allocs_(0)
 {
 }
 QDaqJob::~QDaqJob(void)
@@ -29,12 +38,118 @@ bool QDaqJob::exec()
     //** Job has been locked at the QDaqLoop level
 	if (armed_)
 	{
+        if (budget_) return execBudget();
         // run this job's task
         // and then execute all child tasks
-        ret = run() && subjobs_.exec();
+        ret = runCounted() && subjobs_.exec();
 	}
     return ret;
 }
+bool QDaqJob::runCounted()
+{
+    quint64 n = os::alloc_counter::count();
+    bool ret = blockSize_>1 ? runBlock(blockSize_) : run();
+    allocs_ = os::alloc_counter::count() - n;
+    return ret;
+}
+void QDaqJob::allocReportHelper(QString &S) const
+{
+    foreach(const QDaqJob* job, subjobs_)
+    {
+        if (job->allocs_) S += QString("\n  %1: %2").arg(job->path()).arg(job->allocs_);
+        job->allocReportHelper(S);
+    }
+}
+bool QDaqJob::execBudget()
+{
+    // backing off after overruns with the Skip policy
+    if (skipLeft_)
+    {
+        skipLeft_--;
+        skipped_++;
+        return true;
+    }
+
+    // make the deadline visible to blocking calls
+    deadline_ = QDaqTimeValue::monotonicNs() + 1000000LL*budget_;
+    outerBudget_ = currentBudget_;
+    currentBudget_ = this;
+
+    bool ret = runCounted();
+    bool over = QDaqTimeValue::monotonicNs() > deadline_;
+    if (ret && (!over || overrunPolicy_==Flag))
+    {
+        ret = subjobs_.exec();
+        over = over || QDaqTimeValue::monotonicNs() > deadline_;
+    }
+
+    currentBudget_ = outerBudget_;
+
+    if (over)
+    {
+        overruns_++;
+        switch (overrunPolicy_)
+        {
+        case NotReady:
+            invalidate();
+            break;
+        case Disarm:
+            pushError("Time budget exceeded");
+            ret = false;
+            break;
+        case Skip:
+            skipLeft_ = backoff_;
+            if (backoff_ < 64) backoff_ *= 2;
+            break;
+        case Flag:
+        default:
+            break;
+        }
+    }
+    else backoff_ = 1;
+    return ret;
+}
+bool QDaqJob::cancelRequested()
+{
+    QDaqJob* j = currentBudget_;
+    if (!j) return false;
+    qint64 now = QDaqTimeValue::monotonicNs();
+    for(; j; j = j->outerBudget_)
+        if (now > j->deadline_) return true;
+    return false;
+}
+void QDaqJob::invalidate()
+{
+    foreach(QDaqJob* job, subjobs_) job->invalidate();
+}
+void QDaqJob::setBudget(uint ms)
+{
+    if (budget_ != ms)
+    {
+        {
+            JobLocker L(this);
+            budget_ = ms;
+        }
+        emit propertiesChanged();
+    }
+}
+void QDaqJob::setOverrunPolicy(OverrunPolicy p)
+{
+    if ((int)p==-1)
+    {
+        throwScriptError("Invalid overrun policy. Availiable options: "
+                         "Flag, Skip, NotReady, Disarm");
+        return;
+    }
+    if (overrunPolicy_ != p)
+    {
+        {
+            JobLocker L(this);
+            overrunPolicy_ = p;
+        }
+        emit propertiesChanged();
+    }
+}
 bool QDaqJob::run()
 {
     QString msg;
@@ -52,6 +167,12 @@ bool QDaqJob::run()
     }
     return true;
 }
+bool QDaqJob::runBlock(uint n)
+{
+    for(uint i=0; i<n; ++i)
+        if (!run()) return false;
+    return true;
+}
 bool QDaqJob::arm_()
 {
     //disarm_();
@@ -134,6 +255,8 @@ bool QDaqJob::setArmed(bool on)
     {
         // lock & arm me and my sub-jobs
         jobLock();
+        top_ = topLoop();
+        blockSize_ = top_ ? top_->blockSize() : 1;
         bool ok = true;
         JobList::iterator i = subjobs_.begin();
         while(ok && i!=subjobs_.end()) {
@@ -143,6 +266,11 @@ bool QDaqJob::setArmed(bool on)
             ++i;
         }
         // finally arm this job also
+        overruns_ = 0;
+        skipLeft_ = 0;
+        backoff_ = 1;
+        skipped_ = 0;
+        allocs_ = 0;
         if (ok) ok = arm_();
 
 
@@ -224,17 +352,37 @@ QDaqLoop* QDaqJob::loop() const
     }
     return 0;
 }
+QMutex* QDaqJob::structLock()
+{
+    QDaqLoop* l = topLoop();
+    return l ? &(l->comm_lock) : &comm_lock;
+}
+qint64 QDaqJob::sampleTimeNs(uint k) const
+{
+    if (!top_ || !armed_) return QDaqTimeValue::nowNs();
+    qint64 t = top_->tickTimeNs();
+    if (k) t -= 1000000LL*k*top_->period()/blockSize_;
+    return t;
+}
 QDaqScriptEngine* QDaqJob::loopEngine() const
 {
     return topLoop()->loop_eng_;
 }
 //////////////////// QDaqLoop //////////////////////////////////////////
 QDaqLoop::QDaqLoop(const QString& name) :
-    QDaqJob(name), count_(0), limit_(0), delay_(0), preload_(0), period_(1000)
+    QDaqJob(name), count_(0), limit_(0), delay_(0), preload_(0), period_(1000),
+    block_(1), pooled_(false), virtual_(false), vstart_(0.), voriginNs_(0), tickTimeNs_(0),
+    ticks_(0), lastK_(-1), tickAllocs_(0), stopping_(0), phase_(0), epochNs_(0), epochTimeNs_(0)
 {
     isLoop_ = true;
     connect(this,SIGNAL(abort()),this,SLOT(disarm()),Qt::QueuedConnection);
     thread_.thisLoop = this;
+    vthread_.thisLoop = this;
+    {
+        os::published<params_t>::editor p(params_);
+        p->limit = limit_;
+        p->delay = delay_;
+    }
 }
 QDaqLoop::~QDaqLoop(void)
 {
@@ -246,30 +394,53 @@ bool QDaqLoop::exec()
 
 
     bool ret = true;
-    comm_lock.lock();
+    // do not block if the loop is being disarmed
+    // (the disarming thread holds the lock and waits for us)
+    while (!comm_lock.tryLock(10))
+        if (stopping_.loadAcquire()) return true;
+    quint64 nalloc = os::alloc_counter::count();
+    if (top_==this)
+    {
+        // time stamp of this repetition
+        if (virtual_) tickTimeNs_ = voriginNs_ + 1000000LL*period_*ticks_;
+        else {
+            // the last grid point that has passed, allowing the timer to
+            // fire up to P/8 early. The index always advances, so a late
+            // repetition never shares its time stamp with the next one.
+            qint64 P = 1000000LL*period_;
+            qint64 t = QDaqTimeValue::monotonicNs() - epochNs_ + P/8;
+            qint64 k = t>0 ? t/P : 0;
+            if (k <= lastK_) k = lastK_ + 1;
+            lastK_ = k;
+            tickTimeNs_ = epochTimeNs_ + k*P;
+        }
+        ticks_++;
+    }
+    if (params_.adopt())
+    {
+        limit_ = params_.current().limit;
+        delay_ = params_.current().delay;
+    }
     if (delay_counter_) delay_counter_--;
     if (delay_counter_ == 0) // loop executes
     {
         // check time for loop statistics
-        t_[1] = 1e-6f*clock_.nsecsElapsed();
-        // Lock  subjobs
-        subjobs_.lock();
+        t_[1] = QDaqTimeValue::monotonicNs();
         // call base-class exec
         ret = QDaqJob::exec();
         // reset counter
         delay_counter_ = delay_;
         // increase count
         count_++;
-        // unlock everything in reverse order
-        subjobs_.unlock();
 
-        emit propertiesChanged();
-        emit updateWidgets();
+        // signals are emitted later from the main thread
+        notify(NotifyProperties | NotifyWidgets);
 
         // loop statistics
-        perfmon[0] << (t_[1] - t_[0]); t_[0] = t_[1];
-        perfmon[1] << (1e-6f*clock_.nsecsElapsed() - t_[1]);
+        perfmon[0] << 1e-6*(t_[1] - t_[0]); t_[0] = t_[1];
+        perfmon[1] << 1e-6*(QDaqTimeValue::monotonicNs() - t_[1]);
     }
+    tickAllocs_ = os::alloc_counter::count() - nalloc;
     comm_lock.unlock();
 
     if (ret && limit_ && count_>=limit_)  ret = false;
@@ -287,17 +458,59 @@ bool QDaqLoop::exec()
 
 bool QDaqLoop::arm_()
 {
+    QDaqLoop* master = syncMaster_ ? syncMaster_->topLoop() : 0;
+    if (master==this) master = 0;
+    if (master && isTop() && !master->armed())
+    {
+        throwScriptError(QString("Sync master %1 is not armed").arg(master->path()));
+        return false;
+    }
+
+    if (params_.adopt())
+    {
+        limit_ = params_.current().limit;
+        delay_ = params_.current().delay;
+    }
     count_ = 0;
     delay_counter_ = preload_;
     aborted_ = false;
+    ticks_ = 0;
+    lastK_ = -1;
+    tickAllocs_ = 0;
+    stopping_.storeRelease(0);
     bool ret = QDaqJob::arm_();
     if (ret)
     {
-        t_[0] = 0;
-        clock_.start();
+        t_[0] = QDaqTimeValue::monotonicNs();
         if (isTop()) {
-            thread_.setInterval(period_);
-            thread_.start();
+            // set the epoch, including the phase offset
+            if (master) {
+                epochNs_ = master->epochNs_;
+                epochTimeNs_ = master->epochTimeNs_;
+            } else {
+                epochNs_ = QDaqTimeValue::monotonicNs();
+                epochTimeNs_ = QDaqTimeValue::toEpochNs(epochNs_);
+            }
+            epochNs_ += 1000000LL*phase_;
+            epochTimeNs_ += 1000000LL*phase_;
+            // first repetition: the next grid point at least one period from now
+            qint64 P = 1000000LL*period_;
+            qint64 d = QDaqTimeValue::monotonicNs() + P - epochNs_;
+            qint64 first = epochNs_ + (d>0 ? (d + P - 1)/P : 0)*P;
+
+            if (virtual_) {
+                voriginNs_ = vstart_ ? QDaqTimeValue(vstart_).toNs() : QDaqTimeValue::nowNs();
+                vthread_.start();
+            } else if (pooled_) {
+                QList<const void*> domains;
+                if (lockDomain()) domains << lockDomain();
+                collectLockDomains(this,domains);
+                QDaqLoopScheduler::instance()->schedule(this,period_,domains,first);
+            } else {
+                thread_.setInterval(period_);
+                thread_.setFirstTimeout(first);
+                thread_.start();
+            }
         }
     }
     return armed();
@@ -305,19 +518,35 @@ bool QDaqLoop::arm_()
 
 void QDaqLoop::disarm_()
 {
+    stopping_.storeRelease(1);
+    vthread_.wait();
+    QDaqLoopScheduler::instance()->unschedule(this);
     thread_.quit();
     thread_.wait();
     QDaqJob::disarm_();
 }
 
+// collect the lock domains of all jobs under obj, including child loops
+void QDaqLoop::collectLockDomains(const QDaqObject *obj, QList<const void *> &domains)
+{
+    foreach(const QDaqObject* child, obj->children())
+    {
+        const QDaqJob* job = qobject_cast<const QDaqJob*>(child);
+        if (job) {
+            const void* d = job->lockDomain();
+            if (d && !domains.contains(d)) domains << d;
+        }
+        collectLockDomains(child,domains);
+    }
+}
+
 void QDaqLoop::setLimit(uint d)
 {
-    if (limit_ != d)
+    if (limit() != d)
     {
-        // locked code
         {
-            QMutexLocker L(&comm_lock);
-            limit_ = d;
+            os::published<params_t>::editor p(params_);
+            p->limit = d;
         }
         emit propertiesChanged();
     }
@@ -325,13 +554,11 @@ void QDaqLoop::setLimit(uint d)
 
 void QDaqLoop::setDelay(uint d)
 {
-    if (delay_ != d)
+    if (delay() != d)
     {
-        // locked code
         {
-            QMutexLocker L(&comm_lock);
-            delay_ = d;
-            //counter_ = delay_;
+            os::published<params_t>::editor p(params_);
+            p->delay = d;
         }
         emit propertiesChanged();
     }
@@ -346,6 +573,104 @@ void QDaqLoop::setPreload(uint d)
     }
 }
 
+void QDaqLoop::setPooled(bool on)
+{
+    if (throwIfArmed()) return;
+    if (pooled_ != on)
+    {
+        pooled_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setLockGroup(const QString &s)
+{
+    if (throwIfArmed()) return;
+    if (lockGroup_ != s)
+    {
+        lockGroup_ = s;
+        emit propertiesChanged();
+    }
+}
+
+const void* QDaqLoop::lockDomain() const
+{
+    if (lockGroup_.isEmpty()) return 0;
+    return QDaqLoopScheduler::instance()->groupDomain(lockGroup_);
+}
+
+int QDaqLoop::worker() const
+{
+    return QDaqLoopScheduler::instance()->workerOf(const_cast<QDaqLoop*>(this));
+}
+
+void QDaqLoop::setBlockSize(uint n)
+{
+    if (throwIfArmed()) return;
+    if (n<1) n = 1;
+    if (block_ != n)
+    {
+        block_ = n;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setVirtualTime(bool on)
+{
+    if (throwIfArmed()) return;
+    if (virtual_ != on)
+    {
+        virtual_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setVirtualStart(double t)
+{
+    if (throwIfArmed()) return;
+    if (vstart_ != t)
+    {
+        vstart_ = t;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setSyncMaster(QDaqObject *o)
+{
+    if (o==syncMaster_) return;
+
+    QDaqLoop* l = 0;
+    if (o) {
+        l = qobject_cast<QDaqLoop*>(o);
+        if (!l || l==this) {
+            throwScriptError(QString("Object %1 is not a valid sync master loop").arg(o->path()));
+            return;
+        }
+    }
+
+    if (throwIfArmed()) return;
+
+    syncMaster_ = l;
+
+    emit propertiesChanged();
+}
+
+void QDaqLoop::setPhase(uint ms)
+{
+    if (throwIfArmed()) return;
+    if (phase_ != ms)
+    {
+        phase_ = ms;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::VirtualTimeThread::run()
+{
+    while (!thisLoop->stopping() && !thisLoop->aborted_)
+        thisLoop->exec();
+}
+
 void QDaqLoop::setPeriod(unsigned int p)
 {
     if (p<10) p=10; // minimum 10 ms
@@ -375,6 +700,17 @@ QString QDaqLoop::stat()
     return S;
 }
 
+QString QDaqLoop::allocReport()
+{
+    if (!os::alloc_counter::enabled())
+        return QString("Allocation counting is not available. "
+                       "QDaq must be built with CONFIG+=alloc_diagnostics.");
+    QString S = QString("Allocations in last repetition: %1").arg(tickAllocs_);
+    if (allocs_) S += QString("\n  %1: %2").arg(path()).arg(allocs_);
+    allocReportHelper(S);
+    return S;
+}
+
 void QDaqLoop::createLoopEngine()
 {
     if (throwIfArmed()) return;
@@ -4,10 +4,10 @@
 #include "QDaqObject.h"
 #include "math_util.h"
 #include "qtimerthread.h"
+#include "os_util.h"
 
 #include <QPointer>
 #include <QAtomicInt>
-#include <QElapsedTimer>
 
 class QDaqScriptEngine;
 class QScriptProgram;
@@ -88,6 +88,60 @@ class QDAQ_EXPORT QDaqJob : public QDaqObject
      */
     Q_PROPERTY(QString disarmCode READ disarmCode WRITE setDisarmCode)
 
+    /** Time budget of the job in ms.
+     *
+     * The maximum time allowed for the job, including its child jobs, in each
+     * repetition. If it is exceeded, the action defined by overrunPolicy
+     * is taken.
+     *
+     * While a job with a budget executes, blocking operations that support it
+     * (e.g. QDaqSerial::read) are cancelled as soon as the budget expires
+     * (see cancelRequested()).
+     *
+     * If budget is 0 (default) there is no limit.
+     */
+    Q_PROPERTY(uint budget READ budget WRITE setBudget)
+
+    /// Action taken when the job exceeds its time budget.
+    Q_PROPERTY(OverrunPolicy overrunPolicy READ overrunPolicy WRITE setOverrunPolicy)
+
+    /** Number of repetitions that exceeded the time budget (read-only).
+     * It is reset to 0 when the job is armed.
+     */
+    Q_PROPERTY(uint overruns READ overruns)
+
+    /** Number of repetitions in which the job was skipped (read-only).
+     *
+     * With overrunPolicy = Skip, see OverrunPolicy.
+     * It is reset to 0 when the job is armed.
+     */
+    Q_PROPERTY(uint skipped READ skipped)
+
+    /** Number of heap allocations made by the job in the last repetition (read-only).
+     *
+     * Allocations in run() (or runBlock()) of this job are counted,
+     * excluding its child jobs. A job suitable for real-time operation should
+     * make no allocations in steady state.
+     *
+     * It is always 0 unless QDaq is built with CONFIG+=alloc_diagnostics
+     * (see os::alloc_counter).
+     */
+    Q_PROPERTY(uint allocations READ allocations)
+
+public:
+    /// Action taken when a job exceeds its time budget.
+    enum OverrunPolicy {
+        Flag,     /**< Count the overrun and continue normally. */
+        Skip,     /**< Skip the child jobs for this repetition, then skip the job
+                       itself for the next 1, 2, 4 ... 64 repetitions while it
+                       keeps overrunning. The back-off is reset when the job
+                       runs within budget again. */
+        NotReady, /**< Skip the child jobs and mark their channels as not ready. */
+        Disarm    /**< Stop the loop with an error. */
+    };
+    Q_ENUM(OverrunPolicy)
+
+private:
     // properties
     QAtomicInt armed_; // only I touch this
 
@@ -100,6 +154,30 @@ protected:
     QPointer<QDaqScriptEngine> loop_eng_;
     // true if it is a loop
     bool isLoop_;
+    // samples processed per repetition, obtained from the top loop when armed
+    uint blockSize_;
+    // the top level loop, obtained when armed
+    QDaqLoop* top_;
+    // time budget
+    uint budget_;
+    OverrunPolicy overrunPolicy_;
+    uint overruns_;
+    // Skip policy: repetitions left to skip, next back-off and total skipped
+    uint skipLeft_, backoff_, skipped_;
+    // end of the budget on the monotonic clock while executing
+    qint64 deadline_;
+    // the job with a budget that encloses this one while executing
+    QDaqJob* outerBudget_;
+    // allocations in the last repetition
+    uint allocs_;
+
+    // call run() or runBlock() and count allocations
+    bool runCounted();
+    // append to S the jobs below this one that allocated memory
+    void allocReportHelper(QString& S) const;
+
+    // exec() for jobs with a time budget
+    bool execBudget();
 
 	/** Performs internal initialization for the job.
      *
@@ -150,7 +228,7 @@ protected:
     bool setArmed(bool on);
 
 public:
-	bool armed() { return armed_; }
+	bool armed() const { return armed_.load(); }
 
     const QString& runCode() const { return runCode_; }
     const QString& armCode() const { return armCode_; }
@@ -160,6 +238,23 @@ public:
     void setArmCode(const QString& s);
     void setDisarmCode(const QString& s);
 
+    uint budget() const { return budget_; }
+    OverrunPolicy overrunPolicy() const { return overrunPolicy_; }
+    uint overruns() const { return overruns_; }
+    uint skipped() const { return skipped_; }
+    uint allocations() const { return allocs_; }
+    void setBudget(uint ms);
+    void setOverrunPolicy(OverrunPolicy p);
+
+    /**
+     * @brief Returns true if the time budget of the executing job has expired.
+     *
+     * It refers to the jobs executing in the calling thread. Blocking operations,
+     * such as waiting for a device reply, should call this function periodically
+     * and abort if it returns true.
+     */
+    static bool cancelRequested();
+
 protected:
     // finds all subjobs
     void discoverJobs();
@@ -174,8 +269,6 @@ protected:
                     if (!job->exec()) return false;
                 return true;
             }
-            void lock() { for(iterator i=begin(); i<end(); ++i) (*i)->jobLock(); }
-            void unlock() { for(iterator i=end()-1; i>=begin(); --i) (*i)->jobUnlock(); }
 	};
 
 	friend class JobLocker;
@@ -188,15 +281,28 @@ protected:
 	};
     JobList subjobs_;
 
-    // lock my child jobs
+    /**
+     * @brief The mutex that protects the job structure.
+     *
+     * This is the comm_lock of the top level loop, which is held
+     * during each loop repetition. If the job does not belong
+     * to a loop, its own comm_lock is returned.
+     *
+     * Structural changes (e.g. re-allocating buffers, arming) must be done
+     * while holding this lock. Simple parameter changes should not take it,
+     * they are published lock-free (see os::published).
+     */
+    QMutex* structLock();
+
+    // lock the job structure and my own mutex
     void jobLock() {
+        structLock()->lock();
         comm_lock.lock();
-        subjobs_.lock();
     }
-    // unlock my child jobs
+    // unlock in reverse order
     void jobUnlock() {
-        subjobs_.unlock();
         comm_lock.unlock();
+        structLock()->unlock();
     }
 
 protected:
@@ -227,6 +333,29 @@ protected:
      */
     virtual bool run();
 
+    /**
+     * @brief Process a block of n samples.
+     *
+     * Called by exec() instead of run() when the top level loop
+     * operates in block mode (QDaqLoop::blockSize > 1).
+     *
+     * The default implementation calls run() n times, thus
+     * jobs that do not reimplement it retain their per-sample behavior.
+     *
+     * @return false if a serious error occured, true otherwise.
+     */
+    virtual bool runBlock(uint n);
+
+    /**
+     * @brief Mark the output of this job as not valid.
+     *
+     * Called when the job exceeds its time budget and
+     * the overrunPolicy is NotReady.
+     *
+     * The default implementation invalidates all child jobs.
+     */
+    virtual void invalidate();
+
     // Throws script exception and error if called while the job is armed.
 	bool throwIfArmed();
 
@@ -248,6 +377,33 @@ public:
     QDaqLoop* loop() const;
     /// Returns the QDaqScriptEngine of the top level loop.
     virtual QDaqScriptEngine* loopEngine() const;
+
+    /**
+     * @brief Time stamp of a sample in the current loop repetition.
+     *
+     * Returns the QDaqLoop::tickTime of the top level loop. In block mode,
+     * k counts samples back from the newest one in the block, which are
+     * assumed equally spaced within the loop period.
+     *
+     * If the job is not in an armed loop, QDaqTimeValue::now() is returned.
+     */
+    double sampleTime(uint k = 0) const { return 1e-9*sampleTimeNs(k); }
+    /// Same as sampleTime() in ns since the epoch.
+    qint64 sampleTimeNs(uint k = 0) const;
+
+    /**
+     * @brief Returns the lock domain of this job.
+     *
+     * Jobs that serialize on a common resource, e.g. devices
+     * communicating through the same QDaqInterface, should return
+     * the same non-null pointer.
+     *
+     * It is used by QDaqLoopScheduler to assign loops sharing
+     * a lock domain to the same worker thread.
+     *
+     * The default implementation returns 0 (no lock domain).
+     */
+    virtual const void* lockDomain() const { return 0; }
 };
 
 /**
@@ -268,8 +424,29 @@ execution scenarios:
 A QDaqLoop that has no QDaqLoop ancestor is considered a "top level loop"
 (isTop() returns true). Otherwise the loop is a child-loop.
 
+If the blockSize property of the top level loop is larger than 1, the loop
+operates in block mode: at each repetition every job processes a block of
+blockSize samples through QDaqJob::runBlock(). The period should then be set
+to blockSize times the sampling period.
+
+If the virtualTime property is set, the top level loop does not wait for
+a timer. Repetitions are executed back-to-back in a separate thread and
+a simulated clock advances by period at each repetition. QDaqChannel objects
+of type Clock record this simulated time. The loop runs until
+its limit is reached or until a job returns false, e.g.,
+when a Playback channel exhausts its data. This is used for off-line
+processing of recorded data.
+
+Each top level loop has an epoch, a reference point on the monotonic clock
+(QDaqTimeValue::monotonicNs()) taken when the loop is armed. Repetitions
+occur at epoch + phase + k*period and are stamped with the corresponding
+time (tickTime). If syncMaster is set, the loop adopts the epoch of the
+master loop, thus the repetitions of both loops are aligned and their
+time stamps are on a common time base.
+
 When arm() is called on a top level loop, a new QTimerThread is spawned that
-calls exec() at each timer repetition.
+calls exec() at each timer repetition. If the pooled property is set,
+the loop is instead scheduled on the shared worker threads of QDaqLoopScheduler.
 
 If arm() is called on a child loop, then it simply arms all child jobs.
 The exec() function of a child loop is called from the top level loop thread.
@@ -316,13 +493,129 @@ class QDAQ_EXPORT QDaqLoop : public QDaqJob
      */
     Q_PROPERTY(uint period READ period WRITE setPeriod)
 
+    /** Execute the loop on the shared worker pool.
+     *
+     * If true, the top level loop is executed by QDaqLoopScheduler
+     * instead of its own QTimerThread.
+     *
+     * This is meaningful only for the top level loop. It
+     * cannot be changed while the loop is armed.
+     */
+    Q_PROPERTY(bool pooled READ pooled WRITE setPooled)
+
+    /** Named lock domain of the loop.
+     *
+     * Pooled loops with the same non-empty lockGroup, or containing child
+     * loops with this lockGroup, are executed by the same worker thread
+     * of QDaqLoopScheduler, as if they shared a device interface.
+     *
+     * It cannot be changed while the loop is armed.
+     */
+    Q_PROPERTY(QString lockGroup READ lockGroup WRITE setLockGroup)
+
+    /** Index of the QDaqLoopScheduler worker executing the loop (read-only).
+     *
+     * -1 if the loop is not pooled or not armed.
+     */
+    Q_PROPERTY(int worker READ worker)
+
+    /** Number of samples processed at each repetition.
+     *
+     * If larger than 1 each job processes a block of samples per
+     * loop repetition (see QDaqJob::runBlock()). This amortizes the
+     * thread wakeup and signal overhead for high-rate sources.
+     *
+     * The default is 1. This is meaningful only for the top level loop.
+     * It cannot be changed while the loop is armed.
+     */
+    Q_PROPERTY(uint blockSize READ blockSize WRITE setBlockSize)
+
+    /** Run the loop on a simulated clock.
+     *
+     * If true, the top level loop executes repetitions back-to-back
+     * without waiting for the wall clock. The time stamp of each repetition
+     * (tickTime) advances by period.
+     *
+     * This is meaningful only for the top level loop. It
+     * cannot be changed while the loop is armed.
+     */
+    Q_PROPERTY(bool virtualTime READ virtualTime WRITE setVirtualTime)
+
+    /** Start time of the simulated clock.
+     *
+     * In seconds since the Unix epoch (QDaqTimeValue).
+     * If 0 (default), the simulated clock starts at the time the loop is armed.
+     * Set a fixed value to obtain identical time stamps between runs.
+     */
+    Q_PROPERTY(double virtualStart READ virtualStart WRITE setVirtualStart)
+
+    /** Time stamp of the current repetition (read-only).
+     *
+     * In seconds since the Unix epoch (QDaqTimeValue). It is taken once
+     * at the start of each repetition of the top level loop: the point of
+     * the epoch grid (epoch + phase + k*period) that the repetition belongs
+     * to, on the monotonic-disciplined clock of QDaqTimeValue, or the
+     * simulated clock in virtualTime mode. Successive repetitions always have
+     * increasing time stamps. Internally it has ns resolution (tickTimeNs()).
+     */
+    Q_PROPERTY(double tickTime READ tickTime)
+
+    /** A loop that provides the time base.
+     *
+     * If set, this loop adopts the epoch of the syncMaster loop when armed,
+     * so that repetitions of both loops are aligned (offset by phase) and are
+     * stamped on a common time base. The master must be armed first.
+     *
+     * This is meaningful only for the top level loop. It
+     * cannot be changed while the loop is armed.
+     */
+    Q_PROPERTY(QDaqObject* syncMaster READ syncMaster WRITE setSyncMaster)
+
+    /** Phase offset of the repetitions relative to the epoch in ms.
+     *
+     * This is meaningful only for the top level loop. It
+     * cannot be changed while the loop is armed.
+     */
+    Q_PROPERTY(uint phase READ phase WRITE setPhase)
+
+    /** Number of heap allocations in the last repetition of the loop (read-only).
+     *
+     * Includes all child jobs and loops and the loop's own overhead.
+     * Use allocReport() to find the jobs responsible.
+     *
+     * It is always 0 unless QDaq is built with CONFIG+=alloc_diagnostics
+     * (see os::alloc_counter).
+     */
+    Q_PROPERTY(uint tickAllocations READ tickAllocations)
+
 protected:
-    uint count_, limit_, delay_, preload_,period_; // properties
+    uint count_, limit_, delay_, preload_,period_, block_; // properties
     uint delay_counter_;
     bool aborted_;
-
-    // for loop timing
-    QElapsedTimer clock_;
+    bool pooled_;
+    QString lockGroup_;
+    bool virtual_;
+    double vstart_;
+    qint64 voriginNs_, tickTimeNs_; // ns since the epoch
+    // repetitions of the top level loop since armed
+    quint64 ticks_;
+    // grid index of the last repetition time stamp
+    qint64 lastK_;
+    // allocations in the last repetition
+    uint tickAllocs_;
+    // set while the loop is being disarmed
+    QAtomicInt stopping_;
+    // time base
+    QPointer<QDaqLoop> syncMaster_;
+    uint phase_;
+    qint64 epochNs_; // epoch on the monotonic clock
+    qint64 epochTimeNs_; // epoch in ns since the Unix epoch
+
+    // parameters changed while the loop runs
+    struct params_t {
+        uint limit, delay;
+    };
+    os::published<params_t> params_;
 
     /**
      * @brief Called when a loop is executed.
@@ -334,13 +627,14 @@ protected:
      * according to the order of the child-loop in the
      * tree structure.
      *
-     * This function first locks the mutexes of all child jobs
-     * to prevent access from other threads. Then it calls
-     * QDaqJob::exec() which runs all child jobs. Finally it unlocks
-     * the mutexes in the reverse order as they were locked.
+     * This function locks only the loop's own mutex, which
+     * guards the structure of the job tree (see structLock()).
+     * The child jobs are not locked individually; their parameters
+     * are adopted lock-free at the start of their run().
+     * Then it calls QDaqJob::exec() which runs all child jobs.
      *
      * The signals updateWidgets() and propertiesChanged()
-     * are emitted at each valid repetition.
+     * are requested at each valid repetition with notify().
      *
      * @return
      */
@@ -359,33 +653,74 @@ protected:
 
     LoopTimerThread thread_;
 
+    // executes the loop back-to-back in virtualTime mode
+    class VirtualTimeThread : public QThread
+    {
+    protected:
+        virtual void run();
+    public:
+        QDaqLoop* thisLoop;
+    };
+
+    VirtualTimeThread vthread_;
+
+    // the shared scheduler calls exec()
+    friend class QDaqLoopScheduler;
+
+    // find the lock domains of all jobs below obj
+    static void collectLockDomains(const QDaqObject* obj, QList<const void*>& domains);
+
     // the () operator is defined for the timer thread
     bool operator()() { return exec(); }
 
     // Loop performance monitors
     // perfmon[0] : average loop period (ms)
     // perfmon[1] : average loop load-time (ms)
-    typedef math::running_average<float,10> perfmon_t;
+    typedef math::running_average<double,10> perfmon_t;
     perfmon_t perfmon[2];
-    float t_[2];
+    qint64 t_[2]; // monotonicNs() at the start of the last 2 repetitions
 
 public:
     Q_INVOKABLE explicit QDaqLoop(const QString& name);
     virtual ~QDaqLoop(void);
 
-    uint limit() const { return limit_; }
+    uint limit() const { return params_.staged().limit; }
     uint count() const { return count_; }
-    uint delay() const { return delay_; }
+    uint delay() const { return params_.staged().delay; }
     uint preload() const { return preload_; }
     uint period() const { return period_; }
+    bool pooled() const { return pooled_; }
+    QString lockGroup() const { return lockGroup_; }
+    int worker() const;
+    uint blockSize() const { return block_; }
+    bool virtualTime() const { return virtual_; }
+    double virtualStart() const { return vstart_; }
+    double tickTime() const { return 1e-9*tickTimeNs_; }
+    /// Time stamp of the current repetition in ns since the epoch
+    qint64 tickTimeNs() const { return tickTimeNs_; }
+    QDaqObject* syncMaster() const { return syncMaster_.data(); }
+    uint phase() const { return phase_; }
+    uint tickAllocations() const { return tickAllocs_; }
+    /// True while the loop is being disarmed
+    bool stopping() const { return stopping_.loadAcquire(); }
     void setLimit(uint d);
     void setDelay(uint d);
     void setPreload(uint d);
     void setPeriod(uint p);
+    void setPooled(bool on);
+    void setLockGroup(const QString& s);
+    void setBlockSize(uint n);
+    void setVirtualTime(bool on);
+    void setVirtualStart(double t);
+    void setSyncMaster(QDaqObject* o);
+    void setPhase(uint ms);
 
     /// Return true if this is a top level loop
     bool isTop() const { return this==topLoop(); }
 
+    /// The domain of lockGroup, if set.
+    virtual const void* lockDomain() const;
+
     /// Return the parent loop of this loop
     QDaqLoop* parentLoop() const;
 
@@ -418,6 +753,12 @@ public slots:
     /// Print loop statistics.
     QString stat();
 
+    /** List the jobs that allocated memory in the last repetition.
+     *
+     * Requires QDaq built with CONFIG+=alloc_diagnostics.
+     */
+    QString allocReport();
+
     /**
      * @brief Create a dedicated QDaqScriptEngine.
      *
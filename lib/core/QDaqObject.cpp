@@ -23,7 +23,7 @@ const char* QDaq::QtVersion() { return QT_VERSION_STR; }
 
 
 QDaqObject::QDaqObject(const QString& name) :
-QObject(0), comm_lock(QMutex::Recursive)
+QObject(0), nextPending_(0), comm_lock(QMutex::Recursive)
 {
     setObjectName(name);
     qDebug() << "QDaqObject constructor" << path() << "@" << (void*)this;
@@ -31,6 +31,13 @@ QObject(0), comm_lock(QMutex::Recursive)
 
 QDaqObject::~QDaqObject(void)
 {
+    // the object is on the pending list until its flags are delivered
+    if (notify_.loadAcquire())
+    {
+        takePending();
+        pendingTaken_.removeOne(this);
+    }
+
     QDaqObjectList lst = children();
     foreach(QDaqObject* obj, lst)
     {
@@ -205,6 +212,28 @@ void QDaqObject::pushError(const QString& type, const QString& descr) const
     root()->postError(e);
 }
 
+void QDaqObject::deliverNotifications(int flags)
+{
+    if (flags & NotifyProperties) emit propertiesChanged();
+    if (flags & NotifyWidgets) emit updateWidgets();
+}
+
+void QDaqObject::pushPending()
+{
+    QDaqObject* head = pendingHead_.loadAcquire();
+    do {
+        nextPending_ = head;
+    } while (!pendingHead_.testAndSetOrdered(head, this, head));
+}
+
+void QDaqObject::takePending()
+{
+    // the objects keep their flags, thus they are not pushed again
+    // while their links are followed
+    QDaqObject* obj = pendingHead_.fetchAndStoreAcquire(0);
+    for(; obj; obj = obj->nextPending_) pendingTaken_ << obj;
+}
+
 void listPropertiesHelper(const QDaqObject* m_object, QString& S, const QMetaObject* metaObject, int& level)
 {
 	const QMetaObject* super = metaObject->superClass();
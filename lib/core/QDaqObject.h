@@ -9,6 +9,8 @@
 #include <QMetaType>
 #include <QScriptable>
 #include <QMutex>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 
 #include "QDaqGlobal.h"
 
@@ -111,7 +113,11 @@ class QDAQ_EXPORT QDaqObject : public QObject, protected QScriptable
 
 protected:
 
-	/// Push an error in the error queue
+	/** Push an error in the error queue
+     *
+     * The error record is created and posted to the main thread, which
+     * allocates memory. In loop code it should be called only on error.
+     */
     void pushError(const QString& type, const QString& descr = QString()) const;
 
 	/// Throw a script error with message msg
@@ -150,6 +156,37 @@ protected:
 
     friend class QDaqH5File;
 
+    /// Flags for notify()
+    enum NotifyFlags {
+        NotifyProperties = 0x1, /**< emit propertiesChanged() */
+        NotifyWidgets = 0x2,    /**< emit updateWidgets() */
+        NotifyUser = 0x100      /**< first flag available to subclasses */
+    };
+
+    /** Request notification signals from a loop thread.
+     *
+     * Emitting a signal to the main thread posts an event, which
+     * allocates memory. notify() only sets the flags, without locking or
+     * allocating. The first request puts the object on a lock-free list,
+     * which QDaqRoot empties periodically in the main thread calling
+     * deliverNotifications(), thus all requests made in between are
+     * coalesced into one signal.
+     */
+    void notify(int flags)
+    {
+        if (flags && !notify_.fetchAndOrRelease(flags)) pushPending();
+    }
+
+    /** Emit the signals for the pending notification flags.
+     *
+     * Called by QDaqRoot in the main thread. Subclasses defining
+     * their own flags (NotifyUser and above) reimplement this to handle them
+     * and call the base class implementation.
+     */
+    virtual void deliverNotifications(int flags);
+
+    friend class QDaqRoot;
+
     // for handling child events
     virtual void childEvent ( QChildEvent * event );
 
@@ -157,6 +194,19 @@ protected:
     // so that we can handle child ordering stuff (insertBefore etc.)
     QDaqObjectList children_;
 
+    // pending notify() flags
+    QAtomicInt notify_;
+
+    // Objects with pending flags form a lock-free stack, linked by
+    // nextPending_. An object is pushed by the notify() that sets its
+    // first flag and stays on the list until its flags are cleared.
+    QDaqObject* nextPending_;
+    static QAtomicPointer<QDaqObject> pendingHead_;
+    // objects taken from the stack and not yet delivered. Main thread only
+    static QDaqObjectList pendingTaken_;
+    void pushPending();
+    static void takePending();
+
     // the root object
     static QDaqRoot* root_;
 
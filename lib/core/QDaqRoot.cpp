@@ -2,6 +2,9 @@
 #include "QDaqJob.h"
 #include "QDaqLogFile.h"
 #include "QDaqChannel.h"
+#include "QDaqChannelBank.h"
+#include "QDaqGenerator.h"
+#include "QDaqVirtualChannel.h"
 #include "QDaqDataBuffer.h"
 #include "QDaqSession.h"
 #include "QDaqIde.h"
@@ -15,9 +18,12 @@
 #include <QDir>
 #include <QPluginLoader>
 #include <QLibraryInfo>
+#include <QTimer>
 #include <QDebug>
 
 QDaqRoot* QDaqObject::root_;
+QAtomicPointer<QDaqObject> QDaqObject::pendingHead_;
+QDaqObjectList QDaqObject::pendingTaken_;
 
 QDaqRoot::QDaqRoot(void) : QDaqObject("qdaq"), ideWindow_(0)
 {
@@ -29,6 +35,9 @@ QDaqRoot::QDaqRoot(void) : QDaqObject("qdaq"), ideWindow_(0)
     registerClass(&QDaqJob::staticMetaObject);
     registerClass(&QDaqLoop::staticMetaObject);
     registerClass(&QDaqChannel::staticMetaObject);
+    registerClass(&QDaqChannelBank::staticMetaObject);
+    registerClass(&QDaqGenerator::staticMetaObject);
+    registerClass(&QDaqVirtualChannel::staticMetaObject);
     registerClass(&QDaqDataBuffer::staticMetaObject);
 
     // DAQ objects/devices
@@ -55,6 +64,10 @@ QDaqRoot::QDaqRoot(void) : QDaqObject("qdaq"), ideWindow_(0)
 
     rootSession_ = new QDaqSession(this);
 
+    notifyTimer_ = new QTimer(this);
+    connect(notifyTimer_,SIGNAL(timeout()),this,SLOT(onNotifyTimer()));
+    notifyTimer_->start(NOTIFY_INTERVAL);
+
 }
 
 void jobDisarmHelper(QDaqObjectList lst)
@@ -130,6 +143,24 @@ QList<const QMetaObject*> QDaqRoot::registeredClasses() const
 	return lst;
 }
 
+void QDaqRoot::deliverPending()
+{
+    takePending();
+    // oldest first. A slot may delete an object still on the list,
+    // which then removes itself
+    while (!pendingTaken_.isEmpty())
+    {
+        QDaqObject* obj = pendingTaken_.takeLast();
+        int flags = obj->notify_.fetchAndStoreAcquire(0);
+        if (flags) obj->deliverNotifications(flags);
+    }
+}
+
+void QDaqRoot::onNotifyTimer()
+{
+    deliverPending();
+}
+
 void QDaqRoot::onError(const QDaqError &err)
 {
     error_queue_.push(err);
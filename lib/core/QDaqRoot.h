@@ -11,6 +11,10 @@
 class QDaqLogFile;
 class QDaqIDE;
 class QDaqSession;
+class QTimer;
+
+// interval in ms for delivering notifications from loop threads
+#define NOTIFY_INTERVAL 40
 
 struct QDaqPluginManager
 {
@@ -53,6 +57,11 @@ struct QDaqPluginManager
  *   - the IDE window can be obtained by ideWindow()
  *   - the root script session, rootSession()
  *
+ * QDaqRoot also delivers the notifications requested by QDaqObject::notify()
+ * from loop threads. Every NOTIFY_INTERVAL ms it emits the pending signals in
+ * the main thread for the objects on the lock-free pending list, without
+ * scanning the QDaq tree.
+ *
  * @ingroup Core
  *
  */
@@ -71,6 +80,10 @@ protected:
     QDaqIDE* ideWindow_;
     QDaqSession* rootSession_;
     QDaqErrorQueue error_queue_;
+    QTimer* notifyTimer_;
+
+    // deliver the notifications of the objects on the pending list
+    static void deliverPending();
 
 public:
     QDaqRoot(void);
@@ -127,6 +140,8 @@ public slots:
 private slots:
     // connected (queued connection) to signal error()
     void onError(const QDaqError& err);
+    // connected to notifyTimer_
+    void onNotifyTimer();
 
 signals:
     // used internally by this class
@@ -8,6 +8,9 @@
 
 #include <QColor>
 #include <QPointF>
+#include <QElapsedTimer>
+
+#include <chrono>
 
 QScriptValue toScriptValue(QScriptEngine *engine, const QColor &clr)
 {
@@ -235,6 +238,27 @@ int QDaqTypes::registerWithJS(QScriptEngine* eng)
 
 }
 
+qint64 QDaqTimeValue::monotonicNs()
+{
+    // started once, on first use
+    struct MonotonicClock {
+        QElapsedTimer t;
+        MonotonicClock() { t.start(); }
+    };
+    static MonotonicClock clock;
+    return clock.t.nsecsElapsed();
+}
+qint64 QDaqTimeValue::toEpochNs(qint64 monotonic)
+{
+    // offset of the epoch from the monotonic clock origin,
+    // read from the system clock once, on first use
+    static const qint64 offset =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()
+            - monotonicNs();
+    return monotonic + offset;
+}
+
 
 
 
@@ -42,51 +42,78 @@ struct QDAQ_EXPORT QDaqTypes {
   @ingroup Core
   @ingroup Types
 
-  Time is represented internaly as a double number
-  corresponding to seconds since 1 Jan 1970
-  as returned by the POSIX ftime function.
-  It is recorded with millisecond resolution.
+  Time is stored internaly as a 64-bit integer number of
+  nanoseconds since 1 Jan 1970 (Unix epoch).
+  For compatibility it converts to/from a double number
+  of seconds since the epoch, which has sub-microsecond resolution
+  for present dates.
+
+  The current time, now() or nowNs(), is derived from the monotonic clock
+  (monotonicNs()) plus an offset to the epoch taken from the system clock
+  once, at first use. Thus time stamps have ns resolution and never jump
+  when the system clock is stepped (e.g. by NTP), so they can be used for
+  rate calculations.
   */
 
 class QDAQ_EXPORT QDaqTimeValue
 {
-    double v_;
+    qint64 ns_;
 
 public:
     /// default constructor
-    QDaqTimeValue() : v_(0.0)
+    QDaqTimeValue() : ns_(0)
     {}
-    /// construct from double
-    explicit QDaqTimeValue(double d) : v_(d)
+    /// construct from double (seconds since the epoch)
+    explicit QDaqTimeValue(double d) : ns_(qRound64(1e9*d))
     {}
     /// copy constructor
-    QDaqTimeValue(const QDaqTimeValue& rhs) : v_(rhs.v_)
+    QDaqTimeValue(const QDaqTimeValue& rhs) : ns_(rhs.ns_)
     {}
 
     /// copy operator
     QDaqTimeValue& operator=(const QDaqTimeValue& rhs)
     {
-        v_ = rhs.v_;
+        ns_ = rhs.ns_;
         return *this;
     }
 
+    /// construct from nanoseconds since the epoch
+    static QDaqTimeValue fromNs(qint64 ns)
+    {
+        QDaqTimeValue t;
+        t.ns_ = ns;
+        return t;
+    }
+    /// nanoseconds since the epoch
+    qint64 toNs() const { return ns_; }
+
     /// type conversion operator to double
-    operator double() { return v_; }
+    operator double() const { return 1e-9*ns_; }
 
     /// convert to QDateTime
-    operator QDateTime()
+    operator QDateTime() const
     {
-        return QDateTime::fromMSecsSinceEpoch(1000*v_);
+        return QDateTime::fromMSecsSinceEpoch(ns_/1000000);
     }
 
     /// return current time in QDaqTimeValue format
     static QDaqTimeValue now()
     {
-        return QDaqTimeValue(0.001*(QDateTime::currentMSecsSinceEpoch()));
+        return fromNs(nowNs());
     }
 
+    /// Current time in ns since the epoch.
+    static qint64 nowNs() { return toEpochNs(monotonicNs()); }
+
+    /// Convert a reading of monotonicNs() to ns since the epoch.
+    static qint64 toEpochNs(qint64 monotonic);
+
+    /// Nanoseconds elapsed on the monotonic clock shared by all loops.
+    /// The origin is arbitrary; only differences are meaningful.
+    static qint64 monotonicNs();
+
     /// convert to string
-    QString toString()
+    QString toString() const
     {
         QTime T = QDateTime(*this).time();
         return T.toString("hh:mm:ss.zzz");
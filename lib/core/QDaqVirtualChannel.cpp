@@ -0,0 +1,235 @@
+#include "QDaqVirtualChannel.h"
+
+#include <muParser.h>
+
+#include <cmath>
+
+// conversions to/from the muParser string type
+static mu::string_type toMuString(const QString& s)
+{
+#if defined(_UNICODE)
+    return s.toStdWString();
+#else
+    return s.toStdString();
+#endif
+}
+static QString fromMuString(const mu::string_type& s)
+{
+#if defined(_UNICODE)
+    return QString::fromStdWString(s);
+#else
+    return QString(s.c_str());
+#endif
+}
+
+QMutex QDaqVirtualChannel::lazyLock_(QMutex::Recursive);
+
+QDaqVirtualChannel::QDaqVirtualChannel(const QString &name) : QDaqChannel(name),
+    vparser_(0),
+    bound_(false), errorReported_(false), cacheValid_(false)
+{
+    lazy_ = true;
+}
+
+QDaqVirtualChannel::~QDaqVirtualChannel()
+{
+    if (vparser_) delete vparser_;
+}
+
+void QDaqVirtualChannel::setExpression(const QString& s)
+{
+    if (s == expression_) return;
+
+    // parse the new expression and find the source names
+    mu::Parser* p = 0;
+    QStringList names;
+    if (!s.isEmpty())
+    {
+        p = new mu::Parser();
+        // '.' is allowed in variable names for channel paths
+        p->DefineNameChars(toMuString("0123456789_."
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ").c_str());
+        try
+        {
+            p->SetExpr(toMuString(s));
+            const mu::varmap_type& vars = p->GetUsedVar();
+            for(mu::varmap_type::const_iterator it = vars.begin(); it!=vars.end(); ++it)
+                names << fromMuString(it->first);
+        }
+        catch (mu::Parser::exception_type &e)
+        {
+            throwScriptError(QString("muParser: %1").arg(fromMuString(e.GetMsg())));
+            delete p;
+            return;
+        }
+    }
+
+    {
+        QMutexLocker L(&lazyLock_);
+        if (vparser_) delete vparser_;
+        vparser_ = p;
+        expression_ = s;
+        names_ = names;
+        sources_.clear();
+        bound_ = false;
+        errorReported_ = false;
+        cacheValid_ = false;
+    }
+
+    emit propertiesChanged();
+}
+
+bool QDaqVirtualChannel::bind()
+{
+    sources_.clear();
+    foreach(const QString& name, names_)
+    {
+        QDaqChannel* ch = qobject_cast<QDaqChannel*>(fromPath(name));
+        if (!ch || ch==this)
+        {
+            if (!errorReported_)
+            {
+                pushError("Invalid source channel", name);
+                errorReported_ = true;
+            }
+            sources_.clear();
+            return false;
+        }
+        sources_ << ch;
+    }
+
+    // reject reference cycles through other virtual channels
+    for(int i=0; i<sources_.size(); ++i)
+    {
+        QDaqVirtualChannel* v = qobject_cast<QDaqVirtualChannel*>(sources_[i].data());
+        QSet<const QDaqVirtualChannel*> visited;
+        if (v && v->dependsOn(this, visited))
+        {
+            if (!errorReported_)
+            {
+                pushError("Circular reference to source channel", names_[i]);
+                errorReported_ = true;
+            }
+            sources_.clear();
+            return false;
+        }
+    }
+
+    int n = names_.size();
+    values_.assign(n, 0.);
+    seqs_.assign(n, 0);
+    vparser_->ClearVar();
+    for(int i=0; i<n; ++i)
+        vparser_->DefineVar(toMuString(names_[i]), &values_[i]);
+
+    bound_ = true;
+    errorReported_ = false;
+    cacheValid_ = false;
+    return true;
+}
+
+bool QDaqVirtualChannel::dependsOn(const QDaqVirtualChannel *target, QSet<const QDaqVirtualChannel *> &visited) const
+{
+    if (visited.contains(this)) return false;
+    visited.insert(this);
+    foreach(const QString& name, names_)
+    {
+        const QDaqVirtualChannel* v = qobject_cast<const QDaqVirtualChannel*>(fromPath(name));
+        if (v && (v==target || v->dependsOn(target, visited))) return true;
+    }
+    return false;
+}
+
+void QDaqVirtualChannel::refresh()
+{
+    QMutexLocker L(&lazyLock_);
+
+    bool ok = vparser_ && (bound_ || bind());
+
+    // a source was deleted
+    if (ok)
+        foreach(const QPointer<QDaqChannel>& ch, sources_)
+            if (!ch) { bound_ = ok = false; cacheValid_ = false; break; }
+
+    // re-evaluate only if a source has changed
+    bool changed = !cacheValid_;
+    if (ok && !changed)
+        for(int i=0; i<sources_.size(); ++i)
+            if (sources_[i]->sequence() != seqs_[i]) { changed = true; break; }
+
+    if (changed)
+    {
+        Sample s;
+        s.value = v_;
+        s.std = 0.;
+        s.time = 0.;
+        s.ready = false;
+        if (ok)
+        {
+            s.ready = true;
+            for(int i=0; i<sources_.size(); ++i)
+            {
+                Sample si;
+                seqs_[i] = sources_[i]->snapshot(si);
+                values_[i] = si.value;
+                s.ready = s.ready && si.ready;
+                if (si.time > s.time) s.time = si.time;
+            }
+            try
+            {
+                s.value = vparser_->Eval();
+            }
+            catch (mu::Parser::exception_type &e)
+            {
+                pushError(QString("muParser"),fromMuString(e.GetMsg()));
+                s.ready = false;
+            }
+            s.ready = s.ready && std::isfinite(s.value);
+        }
+        v_ = s.value;
+        dv_ = s.std;
+        dataReady_ = s.ready;
+        out_.write(s);
+        cacheValid_ = true;
+    }
+}
+
+bool QDaqVirtualChannel::arm_()
+{
+    {
+        QMutexLocker L(&lazyLock_);
+        cacheValid_ = false;
+    }
+    // no processing buffers needed
+    return QDaqJob::arm_();
+}
+
+bool QDaqVirtualChannel::run()
+{
+    if (!QDaqJob::run()) return false;
+    // widgets read the value, which is then computed
+    notify(NotifyWidgets);
+    return true;
+}
+
+bool QDaqVirtualChannel::runBlock(uint n)
+{
+    Q_UNUSED(n);
+    return run();
+}
+
+void QDaqVirtualChannel::clear()
+{
+    // out_ is written only by refresh(), under lazyLock_
+    QMutexLocker L(&lazyLock_);
+    cacheValid_ = false;
+}
+
+void QDaqVirtualChannel::invalidate()
+{
+    {
+        QMutexLocker L(&lazyLock_);
+        cacheValid_ = false;
+    }
+    QDaqJob::invalidate();
+}
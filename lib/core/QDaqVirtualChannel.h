@@ -0,0 +1,103 @@
+#ifndef QDAQVIRTUALCHANNEL_H
+#define QDAQVIRTUALCHANNEL_H
+
+#include "QDaqChannel.h"
+
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <vector>
+
+/**
+ * @brief A channel computed from other channels when it is read.
+ *
+ * @ingroup Core
+ * @ingroup ScriptAPI
+ *
+ * The value of a QDaqVirtualChannel is a muParser expression over other
+ * channels, which are referenced by their path, e.g.
+ * "sqrt(loop.ch1^2 + loop.ch2^2)".
+ *
+ * The expression is not evaluated in a loop. It is evaluated when the
+ * channel is read (value(), std(), dataReady(), snapshot()) and only
+ * if the sequence number of any source channel has changed since the last
+ * evaluation. Thus a derived channel that nobody reads costs nothing.
+ * The channel is ready if all source channels are ready; its timestamp is
+ * the latest of the source timestamps.
+ *
+ * It can be used wherever a QDaqChannel is accepted, e.g. in a
+ * QDaqDataBuffer, a QDaqFilter or a widget. A virtual channel can also
+ * be a source of another virtual channel.
+ *
+ * The channel does not need to be in a loop. If it is, it does no processing
+ * but signals its widgets at each repetition, so that they read the new value.
+ * Averaging, scaling and the other processing properties of QDaqChannel
+ * are not used.
+ *
+ * Source names are resolved when the channel is first read after the
+ * expression is set. If a source cannot be found, or it depends on this
+ * channel through other virtual channels, the channel is not ready and
+ * the names are looked up again at the next read.
+ *
+ * All virtual channels are evaluated under one lock, so channels that
+ * depend on each other can be read from several threads.
+ *
+ */
+class QDAQ_EXPORT QDaqVirtualChannel : public QDaqChannel
+{
+    Q_OBJECT
+
+    /// Expression defining the channel value as a function of other channels.
+    Q_PROPERTY(QString expression READ expression WRITE setExpression)
+    /// Paths of the source channels used in the expression (read-only).
+    Q_PROPERTY(QStringList sources READ sources)
+
+protected:
+    QString expression_;
+    // Serializes the evaluations and expression changes of all virtual
+    // channels. A single lock cannot be taken in opposite orders by two
+    // threads. Recursive because the evaluation of a channel reads its
+    // virtual sources.
+    static QMutex lazyLock_;
+
+    mu::Parser* vparser_;
+    // true if the source names have been resolved
+    bool bound_;
+    bool errorReported_;
+    QStringList names_;
+    QVector< QPointer<QDaqChannel> > sources_;
+    // source values, bound to the parser variables
+    std::vector<double> values_;
+    // source sequence numbers at the last evaluation
+    std::vector<quint32> seqs_;
+    bool cacheValid_;
+
+    // resolve the source names and bind the parser variables
+    bool bind();
+    // true if the expression refers to target, directly or through
+    // other virtual channels
+    bool dependsOn(const QDaqVirtualChannel* target, QSet<const QDaqVirtualChannel*>& visited) const;
+    virtual void refresh();
+
+    virtual bool arm_();
+    virtual bool run();
+    virtual bool runBlock(uint n);
+    virtual void invalidate();
+
+public:
+    Q_INVOKABLE explicit QDaqVirtualChannel(const QString& name);
+    virtual ~QDaqVirtualChannel();
+
+    QString expression() const { return expression_; }
+    QStringList sources() const { return names_; }
+
+    void setExpression(const QString& s);
+
+public slots:
+    /** Invalidate the cached value.
+     * The expression is evaluated again at the next read.
+     */
+    virtual void clear();
+};
+
+#endif // QDAQVIRTUALCHANNEL_H
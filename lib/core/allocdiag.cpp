@@ -0,0 +1,70 @@
+#include "allocdiag.h"
+
+#include <cstdlib>
+
+#if defined(QDAQ_ALLOC_DIAGNOSTICS) && defined(__GLIBC__)
+
+#include <malloc.h>
+#include <errno.h>
+
+// glibc exports its allocator under these names.
+// Our malloc etc. count and then forward the call.
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t sz);
+void* __libc_realloc(void* p, size_t n);
+void* __libc_memalign(size_t align, size_t n);
+}
+
+// initial-exec TLS is accessed without calling into the allocator
+static thread_local quint64 allocs_ __attribute__((tls_model("initial-exec"))) = 0;
+
+extern "C" {
+
+QDAQ_EXPORT void* malloc(size_t n) __THROW
+{
+    allocs_++;
+    return __libc_malloc(n);
+}
+QDAQ_EXPORT void* calloc(size_t n, size_t sz) __THROW
+{
+    allocs_++;
+    return __libc_calloc(n,sz);
+}
+QDAQ_EXPORT void* realloc(void* p, size_t n) __THROW
+{
+    allocs_++;
+    return __libc_realloc(p,n);
+}
+QDAQ_EXPORT void* memalign(size_t align, size_t n) __THROW
+{
+    allocs_++;
+    return __libc_memalign(align,n);
+}
+QDAQ_EXPORT void* aligned_alloc(size_t align, size_t n) __THROW
+{
+    allocs_++;
+    return __libc_memalign(align,n);
+}
+QDAQ_EXPORT int posix_memalign(void** p, size_t align, size_t n) __THROW
+{
+    // align must be a power of 2 multiple of sizeof(void*)
+    if (align % sizeof(void*) || (align & (align - 1))) return EINVAL;
+    allocs_++;
+    void* q = __libc_memalign(align,n);
+    if (!q && n) return ENOMEM;
+    *p = q;
+    return 0;
+}
+
+}
+
+bool os::alloc_counter::enabled() { return true; }
+quint64 os::alloc_counter::count() { return allocs_; }
+
+#else
+
+bool os::alloc_counter::enabled() { return false; }
+quint64 os::alloc_counter::count() { return 0; }
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _allocdiag_h_
+#define _allocdiag_h_
+
+#include "QDaqGlobal.h"
+
+namespace os {
+
+/** Per-thread heap allocation counter.
+
+  \ingroup QDaqCore
+
+  Used to verify that the real-time path of a QDaqLoop does not
+  allocate memory. QDaqJob::allocations and QDaqLoop::tickAllocations
+  are obtained as differences of count() before and after execution.
+
+  The counter is active only if QDaq is built with
+
+  \verbatim
+  qmake CONFIG+=alloc_diagnostics
+  \endverbatim
+
+  which installs hooks in the C library allocator (malloc, calloc,
+  realloc, memalign, posix_memalign, aligned_alloc) and thus also counts
+  C++ new, including aligned new, and Qt container allocations.
+  Currently hooks are available only with the GNU C library.
+  In all other builds enabled() returns false and count() returns 0.
+
+  */
+struct QDAQ_EXPORT alloc_counter
+{
+    /// true if allocations are being counted
+    static bool enabled();
+    /// number of allocations made by the calling thread
+    static quint64 count();
+};
+
+} // namespace os
+
+#endif
@@ -0,0 +1,243 @@
+#include "calibration.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace math;
+
+// y = sum c[i]*x^i and its derivative (Horner scheme)
+static inline double horner(const double* c, unsigned int n, double x, double& dydx)
+{
+    double y = c[n-1], d = 0.;
+    for(unsigned int i=n-1; i-- > 0; ) {
+        d = d*x + y;
+        y = y*x + c[i];
+    }
+    dydx = d;
+    return y;
+}
+
+// a polynomial valid in [lo, hi]
+struct poly_range
+{
+    double lo, hi;
+    unsigned int n;
+    const double* c;
+};
+
+#define RANGE(lo, hi, c) { lo, hi, sizeof(c)/sizeof(double), c }
+
+// select the range containing x, or the nearest one
+static inline const poly_range& findRange(const poly_range* r, unsigned int n, double x)
+{
+    unsigned int i = 0;
+    while (i+1 < n && x > r[i].hi) ++i;
+    return r[i];
+}
+
+// NIST ITS-90 thermocouple tables (NIST Monograph 175)
+// Reference functions E(t), t in degC, E in mV
+
+static const double K_ref0[] = { 0.0, 0.394501280250E-01, 0.236223735980E-04, -0.328589067840E-06,
+    -0.499048287770E-08, -0.675090591730E-10, -0.574103274280E-12, -0.310888728940E-14,
+    -0.104516093650E-16, -0.198892668780E-19, -0.163226974860E-22 };
+static const double K_ref1[] = { -0.176004136860E-01, 0.389212049750E-01, 0.185587700320E-04,
+    -0.994575928740E-07, 0.318409457190E-09, -0.560728448890E-12, 0.560750590590E-15,
+    -0.320207200030E-18, 0.971511471520E-22, -0.121047212750E-25 };
+static const poly_range K_ref[] = { RANGE(-270., 0., K_ref0), RANGE(0., 1372., K_ref1) };
+
+static const double J_ref0[] = { 0.0, 0.503811878150E-01, 0.304758369300E-04, -0.856810657200E-07,
+    0.132281952950E-09, -0.170529583370E-12, 0.209480906970E-15, -0.125383953360E-18,
+    0.156317256970E-22 };
+static const double J_ref1[] = { 0.296456256810E+03, -0.149761277860E+01, 0.317871039240E-02,
+    -0.318476867010E-05, 0.157208190040E-08, -0.306913690560E-12 };
+static const poly_range J_ref[] = { RANGE(-210., 760., J_ref0), RANGE(760., 1200., J_ref1) };
+
+static const double T_ref0[] = { 0.0, 0.387481063640E-01, 0.441944343470E-04, 0.118443231050E-06,
+    0.200329735540E-07, 0.901380195590E-09, 0.226511565930E-10, 0.360711542050E-12,
+    0.384939398830E-14, 0.282135219250E-16, 0.142515947790E-18, 0.487686622860E-21,
+    0.107955392700E-23, 0.139450270620E-26, 0.797951539270E-30 };
+static const double T_ref1[] = { 0.0, 0.387481063640E-01, 0.332922278800E-04, 0.206182434040E-06,
+    -0.218822568460E-08, 0.109968809280E-10, -0.308157587720E-13, 0.454791352900E-16,
+    -0.275129016730E-19 };
+static const poly_range T_ref[] = { RANGE(-270., 0., T_ref0), RANGE(0., 400., T_ref1) };
+
+static const double E_ref0[] = { 0.0, 0.586655087080E-01, 0.454109771240E-04, -0.779980486860E-06,
+    -0.258001608430E-07, -0.594525830570E-09, -0.932140586670E-11, -0.102876055340E-12,
+    -0.803701236210E-15, -0.439794973910E-17, -0.164147763550E-19, -0.396736195160E-22,
+    -0.558273287210E-25, -0.346578420130E-28 };
+static const double E_ref1[] = { 0.0, 0.586655087100E-01, 0.450322755820E-04, 0.289084072120E-07,
+    -0.330568966520E-09, 0.650244032700E-12, -0.191974955040E-15, -0.125366004970E-17,
+    0.214892175690E-20, -0.143880417820E-23, 0.359608994810E-27 };
+static const poly_range E_ref[] = { RANGE(-270., 0., E_ref0), RANGE(0., 1000., E_ref1) };
+
+// Inverse functions t(E), E in mV, t in degC
+
+static const double K_inv0[] = { 0.0, 2.5173462E+01, -1.1662878E+00, -1.0833638E+00, -8.9773540E-01,
+    -3.7342377E-01, -8.6632643E-02, -1.0450598E-02, -5.1920577E-04 };
+static const double K_inv1[] = { 0.0, 2.508355E+01, 7.860106E-02, -2.503131E-01, 8.315270E-02,
+    -1.228034E-02, 9.804036E-04, -4.413030E-05, 1.057734E-06, -1.052755E-08 };
+static const double K_inv2[] = { -1.318058E+02, 4.830222E+01, -1.646031E+00, 5.464731E-02,
+    -9.650715E-04, 8.802193E-06, -3.110810E-08 };
+static const poly_range K_inv[] = { RANGE(-5.891, 0., K_inv0), RANGE(0., 20.644, K_inv1),
+                                    RANGE(20.644, 54.886, K_inv2) };
+
+static const double J_inv0[] = { 0.0, 1.9528268E+01, -1.2286185E+00, -1.0752178E+00, -5.9086933E-01,
+    -1.7256713E-01, -2.8131513E-02, -2.3963370E-03, -8.3823321E-05 };
+static const double J_inv1[] = { 0.0, 1.978425E+01, -2.001204E-01, 1.036969E-02, -2.549687E-04,
+    3.585153E-06, -5.344285E-08, 5.099890E-10 };
+static const double J_inv2[] = { -3.11358187E+03, 3.00543684E+02, -9.94773230E+00, 1.70276630E-01,
+    -1.43033468E-03, 4.73886084E-06 };
+static const poly_range J_inv[] = { RANGE(-8.095, 0., J_inv0), RANGE(0., 42.919, J_inv1),
+                                    RANGE(42.919, 69.553, J_inv2) };
+
+static const double T_inv0[] = { 0.0, 2.5949192E+01, -2.1316967E-01, 7.9018692E-01, 4.2527777E-01,
+    1.3304473E-01, 2.0241446E-02, 1.2668171E-03 };
+static const double T_inv1[] = { 0.0, 2.592800E+01, -7.602961E-01, 4.637791E-02, -2.165394E-03,
+    6.048144E-05, -7.293422E-07 };
+static const poly_range T_inv[] = { RANGE(-5.603, 0., T_inv0), RANGE(0., 20.872, T_inv1) };
+
+static const double E_inv0[] = { 0.0, 1.6977288E+01, -4.3514970E-01, -1.5859697E-01, -9.2502871E-02,
+    -2.6084314E-02, -4.1360199E-03, -3.4034030E-04, -1.1564890E-05 };
+static const double E_inv1[] = { 0.0, 1.7057035E+01, -2.3301759E-01, 6.5435585E-03, -7.3562749E-05,
+    -1.7896001E-06, 8.4036165E-08, -1.3735879E-09, 1.0629823E-11, -3.2447087E-14 };
+static const poly_range E_inv[] = { RANGE(-8.825, 0., E_inv0), RANGE(0., 76.373, E_inv1) };
+
+// the tables of a thermocouple type
+static bool tcTables(calibration::type_t tc, const poly_range*& ref, unsigned int& nref,
+                     const poly_range*& inv, unsigned int& ninv)
+{
+    switch(tc)
+    {
+    case calibration::TypeK: ref = K_ref; nref = 2; inv = K_inv; ninv = 3; return true;
+    case calibration::TypeJ: ref = J_ref; nref = 2; inv = J_inv; ninv = 3; return true;
+    case calibration::TypeT: ref = T_ref; nref = 2; inv = T_inv; ninv = 2; return true;
+    case calibration::TypeE: ref = E_ref; nref = 2; inv = E_inv; ninv = 2; return true;
+    default: return false;
+    }
+}
+
+double calibration::thermocoupleEmf(type_t tc, double t)
+{
+    const poly_range *ref, *inv;
+    unsigned int nref, ninv;
+    if (!tcTables(tc, ref, nref, inv, ninv)) return 0.;
+    const poly_range& r = findRange(ref, nref, t);
+    double d;
+    double e = horner(r.c, r.n, t, d);
+    // type K above 0 degC has an additional exponential term
+    if (tc==TypeK && t > 0.)
+    {
+        const double a0 = 0.118597600000E+00, a1 = -0.118343200000E-03, a2 = 0.126968600000E+03;
+        e += a0*std::exp(a1*(t - a2)*(t - a2));
+    }
+    return e;
+}
+
+double calibration::thermocoupleTemperature(type_t tc, double e, double& dtde)
+{
+    const poly_range *ref, *inv;
+    unsigned int nref, ninv;
+    if (!tcTables(tc, ref, nref, inv, ninv)) { dtde = 0.; return 0.; }
+    const poly_range& r = findRange(inv, ninv, e);
+    return horner(r.c, r.n, e, dtde);
+}
+
+calibration::calibration() : type_(None), ncoef_(0), cjEmf_(0.)
+{
+    rtd_[0] = 100.; rtd_[1] = 3.9083e-3; rtd_[2] = -5.775e-7; rtd_[3] = -4.183e-12;
+}
+
+bool calibration::set(type_t t, const std::vector<double>& coef,
+                      const std::vector<double>& breaks, double coldJunction)
+{
+    unsigned int nc = 0;
+    double rtd[4] = { 100., 3.9083e-3, -5.775e-7, -4.183e-12 };
+    switch(t)
+    {
+    case None:
+        break;
+    case Polynomial:
+        if (coef.empty()) return false;
+        break;
+    case Piecewise:
+    {
+        if (breaks.size() < 2 || coef.empty()) return false;
+        unsigned int m = breaks.size() - 1;
+        if (coef.size() % m) return false;
+        nc = coef.size() / m;
+        for(unsigned int i=0; i<m; ++i)
+            if (!(breaks[i] < breaks[i+1])) return false;
+        break;
+    }
+    case TypeK:
+    case TypeJ:
+    case TypeT:
+    case TypeE:
+        break;
+    case Rtd:
+        if (coef.size()!=0 && coef.size()!=1 && coef.size()!=4) return false;
+        for(unsigned int i=0; i<coef.size(); ++i) rtd[i] = coef[i];
+        if (rtd[0] <= 0. || rtd[1] <= 0.) return false;
+        break;
+    default:
+        return false;
+    }
+
+    type_ = t;
+    c_ = coef;
+    b_ = breaks;
+    ncoef_ = nc;
+    cjEmf_ = thermocoupleEmf(t, coldJunction);
+    for(int i=0; i<4; ++i) rtd_[i] = rtd[i];
+    return true;
+}
+
+double calibration::operator()(double x, double& dydx) const
+{
+    switch(type_)
+    {
+    case Polynomial:
+        return horner(c_.data(), c_.size(), x, dydx);
+    case Piecewise:
+    {
+        // segment k: b[k] <= x < b[k+1]
+        unsigned int m = b_.size() - 1;
+        unsigned int k = std::upper_bound(b_.begin(), b_.end(), x) - b_.begin();
+        k = k > 0 ? k - 1 : 0;
+        if (k >= m) k = m - 1;
+        return horner(c_.data() + k*ncoef_, ncoef_, x - b_[k], dydx);
+    }
+    case TypeK:
+    case TypeJ:
+    case TypeT:
+    case TypeE:
+        return thermocoupleTemperature(type_, x + cjEmf_, dydx);
+    case Rtd:
+    {
+        // R = R0 (1 + A t + B t^2 + C (t - 100) t^3), C = 0 for t >= 0
+        const double R0 = rtd_[0], A = rtd_[1], B = rtd_[2], C = rtd_[3];
+        double q = x/R0;
+        // solution of the quadratic (t >= 0) or starting point (t < 0)
+        double t = B != 0. ? (-A + std::sqrt(A*A - 4*B*(1 - q)))/(2*B) : (q - 1)/A;
+        double drdt = R0*(A + 2*B*t);
+        if (t < 0.)
+        {
+            // Newton iterations including the C term
+            for(int i=0; i<4; ++i)
+            {
+                double f = 1 + A*t + B*t*t + C*(t - 100)*t*t*t - q;
+                double df = A + 2*B*t + C*(4*t - 300)*t*t;
+                t -= f/df;
+            }
+            drdt = R0*(A + 2*B*t + C*(4*t - 300)*t*t);
+        }
+        dydx = 1./drdt;
+        return t;
+    }
+    case None:
+    default:
+        dydx = 1.;
+        return x;
+    }
+}
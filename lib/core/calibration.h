@@ -0,0 +1,72 @@
+#ifndef _calibration_h_
+#define _calibration_h_
+
+#include "QDaqGlobal.h"
+
+#include <vector>
+
+namespace math {
+
+/** Sensor calibration curves.
+
+  \ingroup QDaqCore
+
+  Converts a raw sensor reading x to a physical value y and also
+  returns the derivative dy/dx, which is used to propagate the
+  standard deviation of averaged data.
+
+  Supported curves:
+    - Polynomial: y = c0 + c1*x + ... + cn*x^n, evaluated with the Horner scheme.
+    - Piecewise: polynomial segments between breakpoints b0 < b1 < ... < bm.
+      Each segment k has d+1 coefficients and is evaluated in the local
+      variable x - bk. The coefficients of all m segments are given in one
+      vector of size m*(d+1). The segment is found by binary search; outside
+      [b0, bm] the first or last segment is extrapolated.
+    - Thermocouples of type K, J, T and E: EMF in mV to temperature in degC
+      with the NIST ITS-90 inverse polynomials. The EMF of the reference
+      (cold) junction temperature is added first, computed with the NIST
+      reference polynomials.
+    - Rtd: resistance in Ohm to temperature in degC with the Callendar-Van Dusen
+      equation. The coefficients are R0, A, B, C (default: IEC 60751 Pt100).
+
+  */
+class QDAQ_EXPORT calibration
+{
+public:
+    enum type_t { None, Polynomial, Piecewise, TypeK, TypeJ, TypeT, TypeE, Rtd };
+
+    calibration();
+
+    /** Set the calibration curve.
+     *
+     * Returns false if the coefficients do not match the curve type.
+     * In that case the calibration is not changed.
+     */
+    bool set(type_t t, const std::vector<double>& coef,
+             const std::vector<double>& breaks, double coldJunction = 0.);
+
+    type_t type() const { return type_; }
+    bool active() const { return type_ != None; }
+
+    /// calibrated value of x; the derivative is returned in dydx
+    double operator()(double x, double& dydx) const;
+
+    /// thermocouple EMF in mV at temperature t in degC (NIST reference function)
+    static double thermocoupleEmf(type_t tc, double t);
+    /// thermocouple temperature in degC for EMF e in mV (NIST inverse function)
+    static double thermocoupleTemperature(type_t tc, double e, double& dtde);
+
+private:
+    type_t type_;
+    std::vector<double> c_, b_;
+    // coefficients per piecewise segment
+    unsigned int ncoef_;
+    // EMF of the reference junction (mV)
+    double cjEmf_;
+    // R0, A, B, C of the RTD
+    double rtd_[4];
+};
+
+} // namespace math
+
+#endif
@@ -6,6 +6,10 @@
 #include <QVector>
 #include <QExplicitlySharedDataPointer>
 
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
 
 namespace math {
 
@@ -87,6 +91,14 @@ public:
         dec(head_);
         buff_[head_] = v;
     }
+    /// insert n elements, v[n-1] becomes the last inserted
+    void push(const T* v, unsigned int n)
+    {
+        for(unsigned int i=0; i<n; ++i) {
+            dec(head_);
+            buff_[head_] = v[i];
+        }
+    }
     /// insertion operator is the same as push()
     self_t& operator<< (const T& v)
     {
@@ -150,6 +162,175 @@ public:
 	}
 };
 
+/** Quantile of a sliding window of samples.
+
+  \ingroup QDaqCore
+
+  Samples are inserted with push() together with a running index k, which
+  is incremented by 1 for each new sample. The window contains the last
+  window() samples. value() returns the q-quantile of the samples in the
+  window, linearly interpolated between order statistics:
+  with n samples, r = q*(n-1) and the result is x(floor(r)) + frac(r)*(x(floor(r)+1) - x(floor(r))),
+  where x(i) is the i-th smallest sample. For q = 0.5 this is the median.
+
+  The samples are kept in two heaps, a max-heap with the floor(r)+1 smallest
+  samples and a min-heap with the rest. Samples leaving the window are
+  deleted lazily: they are identified by their index and discarded when they
+  reach the top of a heap. Thus push() costs O(log window).
+
+  Memory is allocated only by setWindow().
+
+  */
+template<class T>
+class sliding_quantile
+{
+    struct item {
+        T v;
+        unsigned int k;
+    };
+    struct less {
+        bool operator()(const item& a, const item& b) const { return a.v < b.v; }
+    };
+    struct greater {
+        bool operator()(const item& a, const item& b) const { return a.v > b.v; }
+    };
+
+    // lo_ is a max-heap, hi_ a min-heap
+    std::vector<item> lo_, hi_;
+    // number of samples of the window in each heap
+    unsigned int nlo_, nhi_;
+    // for each sample in the window, true if it is in lo_
+    std::vector<bool> inlo_;
+    unsigned int mask_;
+    // window size, index of the newest sample
+    unsigned int w_, newest_;
+    double q_;
+
+    bool stale(const item& i) const { return newest_ - i.k >= w_; }
+    // remove stale items from the top
+    void prune()
+    {
+        while (!lo_.empty() && stale(lo_.front())) {
+            std::pop_heap(lo_.begin(),lo_.end(),less());
+            lo_.pop_back();
+        }
+        while (!hi_.empty() && stale(hi_.front())) {
+            std::pop_heap(hi_.begin(),hi_.end(),greater());
+            hi_.pop_back();
+        }
+    }
+    // drop all stale items if a heap has grown too much
+    void compact(std::vector<item>& h, bool isLo)
+    {
+        if (h.size() < 2*w_ + 16) return;
+        unsigned int j = 0;
+        for(unsigned int i=0; i<h.size(); ++i)
+            if (!stale(h[i])) h[j++] = h[i];
+        h.resize(j);
+        if (isLo) std::make_heap(h.begin(),h.end(),less());
+        else std::make_heap(h.begin(),h.end(),greater());
+    }
+    // number of samples that should be in lo_
+    unsigned int target() const
+    {
+        unsigned int n = nlo_ + nhi_;
+        return n ? (unsigned int)(q_*(n-1)) + 1 : 0;
+    }
+    void balance()
+    {
+        unsigned int t = target();
+        prune();
+        while (nlo_ > t) {
+            item i = lo_.front();
+            std::pop_heap(lo_.begin(),lo_.end(),less()); lo_.pop_back();
+            hi_.push_back(i); std::push_heap(hi_.begin(),hi_.end(),greater());
+            inlo_[i.k & mask_] = false;
+            nlo_--; nhi_++;
+            prune();
+        }
+        while (nlo_ < t) {
+            item i = hi_.front();
+            std::pop_heap(hi_.begin(),hi_.end(),greater()); hi_.pop_back();
+            lo_.push_back(i); std::push_heap(lo_.begin(),lo_.end(),less());
+            inlo_[i.k & mask_] = true;
+            nhi_--; nlo_++;
+            prune();
+        }
+    }
+
+public:
+    explicit sliding_quantile(unsigned int w = 1, double q = 0.5) : q_(q)
+    {
+        setWindow(w);
+    }
+    /// set the window size, clear the samples and allocate memory
+    void setWindow(unsigned int w)
+    {
+        if (w < 1) w = 1;
+        w_ = w;
+        unsigned int n = 1;
+        while (n < w+1) n <<= 1;
+        inlo_.assign(n,false);
+        mask_ = n-1;
+        // room for the stale items allowed by compact()
+        lo_.reserve(2*w + 32);
+        hi_.reserve(2*w + 32);
+        clear();
+    }
+    unsigned int window() const { return w_; }
+    /// remove all samples
+    void clear()
+    {
+        lo_.clear(); hi_.clear();
+        nlo_ = nhi_ = 0;
+        newest_ = 0;
+    }
+    /// number of samples in the window
+    unsigned int size() const { return nlo_ + nhi_; }
+    /// set the quantile, 0 <= q <= 1
+    void setQuantile(double q)
+    {
+        q_ = q < 0. ? 0. : (q > 1. ? 1. : q);
+        if (size()) balance();
+    }
+    double quantile() const { return q_; }
+    /// insert sample v with index k. The sample k - window() leaves the window.
+    void push(const T& v, unsigned int k)
+    {
+        if (size()==w_) {
+            // lazy removal, only update the counts
+            if (inlo_[(k - w_) & mask_]) nlo_--; else nhi_--;
+        }
+        newest_ = k;
+        prune();
+        compact(lo_,true);
+        compact(hi_,false);
+        item i;
+        i.v = v; i.k = k;
+        if (nlo_ && !(lo_.front().v < v)) {
+            lo_.push_back(i); std::push_heap(lo_.begin(),lo_.end(),less());
+            inlo_[k & mask_] = true;
+            nlo_++;
+        } else {
+            hi_.push_back(i); std::push_heap(hi_.begin(),hi_.end(),greater());
+            inlo_[k & mask_] = false;
+            nhi_++;
+        }
+        balance();
+    }
+    /// the quantile of the samples in the window
+    T value() const
+    {
+        unsigned int n = size();
+        if (!n) return T(0);
+        double r = q_*(n-1);
+        double f = r - (unsigned int)r;
+        T x = lo_.front().v;
+        if (f>0. && nhi_) x += f*(hi_.front().v - x);
+        return x;
+    }
+};
+
 
 
 template<class T>
@@ -464,6 +645,72 @@ public:
     }
 };
 
+/** The xoshiro256** pseudo-random number generator.
+
+  \ingroup QDaqCore
+
+  A small and fast generator (D. Blackman and S. Vigna) with a 256-bit
+  state and period 2^256 - 1. Each object carries its own state, so
+  generators used in different threads share nothing and need no locking.
+
+  The state is initialized from a 64-bit seed with the splitmix64 generator.
+
+  */
+class xoshiro256
+{
+    quint64 s_[4];
+    // second gaussian deviate of the last pair
+    double gauss_;
+    bool hasGauss_;
+
+    static quint64 rotl(quint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    explicit xoshiro256(quint64 seed = 0) { setSeed(seed); }
+
+    /// re-initialize the state from seed
+    void setSeed(quint64 seed)
+    {
+        for(int i=0; i<4; ++i) {
+            quint64 z = (seed += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            s_[i] = z ^ (z >> 31);
+        }
+        hasGauss_ = false;
+    }
+    /// next 64-bit random number
+    quint64 next()
+    {
+        quint64 r = rotl(s_[1] * 5, 7) * 9;
+        quint64 t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return r;
+    }
+    /// uniform deviate in [0,1)
+    double uniform() { return (next() >> 11) * (1.0/9007199254740992.0); }
+    /// gaussian deviate with zero mean and unit variance (polar method)
+    double gaussian()
+    {
+        if (hasGauss_) { hasGauss_ = false; return gauss_; }
+        double u, v, s;
+        do {
+            u = 2*uniform() - 1;
+            v = 2*uniform() - 1;
+            s = u*u + v*v;
+        } while (s >= 1. || s == 0.);
+        s = std::sqrt(-2*std::log(s)/s);
+        gauss_ = v*s;
+        hasGauss_ = true;
+        return u*s;
+    }
+};
+
 } // namespace math
 #endif
 
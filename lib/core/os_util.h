@@ -0,0 +1,190 @@
+#ifndef _os_util_h_
+#define _os_util_h_
+
+#include <QAtomicInt>
+#include <QMutex>
+
+#include <atomic>
+#include <cstring>
+
+namespace os {
+
+/** A lock-free triple buffer.
+
+  \ingroup QDaqCore
+
+  Transfers values of type T from one writer thread to one reader thread
+  without any locking. Neither side ever waits for the other.
+
+  The writer fills the buffer returned by back() and then calls publish().
+  The reader calls update() to adopt the most recently published value
+  and then accesses it with read(). Values published in between
+  two update() calls are skipped, only the latest one is seen by the reader.
+
+  */
+template<class T>
+class triple_buffer
+{
+    T buff_[3];
+    // index of the middle buffer.
+    // bit 2 is set when it contains a value not yet seen by the reader
+    QAtomicInt middle_;
+    // owned by the reader
+    int front_;
+    // owned by the writer
+    int back_;
+
+public:
+    explicit triple_buffer(const T& v = T()) : middle_(1), front_(0), back_(2)
+    {
+        buff_[0] = buff_[1] = buff_[2] = v;
+    }
+    /// writer: the buffer to fill before publish()
+    T& back() { return buff_[back_]; }
+    /// writer: hand the back buffer over to the reader
+    void publish()
+    {
+        back_ = middle_.fetchAndStoreOrdered(back_ | 4) & 3;
+    }
+    /// reader: adopt the latest published value. Returns true if there was one.
+    bool update()
+    {
+        if (!(middle_.loadAcquire() & 4)) return false;
+        front_ = middle_.fetchAndStoreOrdered(front_) & 3;
+        return true;
+    }
+    /// reader: the current value
+    const T& read() const { return buff_[front_]; }
+    /// set all buffers to v. Only while neither side is active.
+    void reset(const T& v)
+    {
+        buff_[0] = buff_[1] = buff_[2] = v;
+        middle_.storeRelease(middle_.loadAcquire() & 3);
+    }
+};
+
+/** A set of parameters published to a real-time thread.
+
+  \ingroup QDaqCore
+
+  Used by QDaqJob objects to change their configuration from the GUI or
+  script thread while they are executed in a loop thread.
+
+  Setters modify the staged copy through an editor object. When the editor
+  goes out of scope the new values are published. The loop thread calls
+  adopt() at the start of each repetition and then uses current().
+
+  Writers are serialized by a mutex that is never taken by the reader,
+  thus the loop never waits for the GUI and vice versa.
+
+  @code
+  {
+    os::published<params_t>::editor p(params_);
+    p->gain = v;
+  } // published here
+  @endcode
+
+  */
+template<class T>
+class published
+{
+    triple_buffer<T> tb_;
+    // latest value on the writer side
+    T staged_;
+    // serializes writers
+    QMutex wlock_;
+
+public:
+    explicit published(const T& v = T()) : tb_(v), staged_(v)
+    {}
+
+    /// RAII write access to the staged value
+    class editor
+    {
+        published& p_;
+    public:
+        explicit editor(published& p) : p_(p) { p_.wlock_.lock(); }
+        ~editor()
+        {
+            p_.tb_.back() = p_.staged_;
+            p_.tb_.publish();
+            p_.wlock_.unlock();
+        }
+        T* operator->() { return &p_.staged_; }
+        T& operator*() { return p_.staged_; }
+    };
+
+    /// the latest value written (writer side)
+    const T& staged() const { return staged_; }
+    /// reader: adopt the latest published values. Returns true if changed.
+    bool adopt() { return tb_.update(); }
+    /// reader: the values in use
+    const T& current() const { return tb_.read(); }
+};
+
+/** A sequence lock.
+
+  \ingroup QDaqCore
+
+  Publishes a small value of type T from one writer thread to any number
+  of reader threads. The writer is never blocked and readers never take
+  a lock; a reader repeats its copy only if it overlapped with a write.
+
+  Each write() increments a sequence number, which is returned by read().
+  Readers may compare it with the one of their previous read to find
+  out whether the value has changed.
+
+  T must be trivially copyable. The value is stored in atomic 64-bit words,
+  thus a copy is never torn even on platforms with weak memory ordering.
+
+  */
+template<class T>
+class seqlock
+{
+    enum { N = (sizeof(T) + 7)/8 };
+    // twice the sequence number, odd while a write is in progress
+    QAtomicInteger<quint32> seq_;
+    QAtomicInteger<quint64> data_[N];
+
+    void store(const T& v)
+    {
+        quint64 w[N] = {};
+        std::memcpy(w, &v, sizeof(T));
+        for(int i=0; i<N; ++i) data_[i].store(w[i]);
+    }
+
+public:
+    explicit seqlock(const T& v = T()) : seq_(0) { store(v); }
+
+    /// writer: publish a new value
+    void write(const T& v)
+    {
+        quint32 s = seq_.load();
+        seq_.store(s + 1);
+        std::atomic_thread_fence(std::memory_order_release);
+        store(v);
+        seq_.storeRelease(s + 2);
+    }
+    /// reader: copy the latest value to v and return its sequence number
+    quint32 read(T& v) const
+    {
+        quint64 w[N];
+        quint32 s;
+        for(;;)
+        {
+            s = seq_.loadAcquire();
+            if (s & 1) continue;
+            for(int i=0; i<N; ++i) w[i] = data_[i].load();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load() == s) break;
+        }
+        std::memcpy(&v, w, sizeof(T));
+        return s/2;
+    }
+    /// reader: the sequence number of the latest value
+    quint32 sequence() const { return seq_.loadAcquire()/2; }
+};
+
+} // namespace os
+
+#endif
@@ -0,0 +1,249 @@
+#include "qdaqloopscheduler.h"
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+
+#include <algorithm>
+#include <QSet>
+
+QDaqLoopScheduler* QDaqLoopScheduler::instance()
+{
+    static QDaqLoopScheduler scheduler;
+    return &scheduler;
+}
+
+QDaqLoopScheduler::QDaqLoopScheduler()
+{
+    int n = QThread::idealThreadCount();
+    if (n<1) n = 1;
+    for(int i=0; i<n; ++i) workers_.push_back(new Worker);
+}
+
+QDaqLoopScheduler::~QDaqLoopScheduler()
+{
+    foreach(Worker* w, workers_)
+    {
+        w->stop();
+        delete w;
+    }
+}
+
+void QDaqLoopScheduler::execLoop(QDaqLoop *loop)
+{
+    loop->exec();
+}
+
+void QDaqLoopScheduler::schedule(QDaqLoop *loop, uint period, const QList<const void *> &domains, qint64 start)
+{
+    QMutexLocker M(&migrate_);
+    Worker* w = 0;
+    // loops migrated to w and their previous workers
+    QList<QDaqLoop*> moved;
+    QList<Worker*> from;
+    {
+        QMutexLocker L(&mutex_);
+
+        if (loopWorker_.contains(loop)) return;
+
+        // a loop sharing a lock domain goes to the same worker
+        int k = -1;
+        foreach(const void* d, domains)
+        {
+            if (domains_.contains(d)) { k = domains_[d].worker; break; }
+        }
+        // otherwise select the least loaded worker
+        if (k<0)
+        {
+            k = 0;
+            for(int i=1; i<workers_.size(); ++i)
+                if (workers_[i]->load < workers_[k]->load) k = i;
+        }
+
+        // If the domains are served by other workers as well, migrate
+        // to k all loops connected to them through common domains
+        QSet<const void*> joined = QSet<const void*>::fromList(domains);
+        bool grow = true;
+        while (grow)
+        {
+            grow = false;
+            QHash<QDaqLoop*, int>::iterator it = loopWorker_.begin();
+            for(; it!=loopWorker_.end(); ++it)
+            {
+                if (it.value()==k) continue;
+                const QList<const void*>& ld = loopDomains_[it.key()];
+                bool shared = false;
+                foreach(const void* d, ld) if (joined.contains(d)) { shared = true; break; }
+                if (!shared) continue;
+                moved << it.key();
+                from << workers_[it.value()];
+                workers_[it.value()]->load--;
+                workers_[k]->load++;
+                it.value() = k;
+                foreach(const void* d, ld) joined.insert(d);
+                grow = true;
+            }
+        }
+        foreach(const void* d, joined)
+            if (domains_.contains(d)) domains_[d].worker = k;
+
+        foreach(const void* d, domains)
+        {
+            if (domains_.contains(d)) domains_[d].refs++;
+            else {
+                Domain dm;
+                dm.worker = k;
+                dm.refs = 1;
+                domains_.insert(d,dm);
+            }
+        }
+
+        loopWorker_.insert(loop,k);
+        loopDomains_.insert(loop,domains);
+        w = workers_[k];
+        w->load++;
+    }
+
+    if (!w->isRunning()) w->start();
+
+    // first stop all migrated loops, then restart them on w,
+    // so that no domain is ever served by two threads
+    QList<Task> tasks;
+    for(int i=0; i<moved.size(); ++i)
+    {
+        Task t;
+        if (from[i]->take(moved[i], t)) tasks << t;
+    }
+    foreach(const Task& t, tasks) w->add(t);
+
+    w->add(loop, 1000000LL*period, start);
+}
+
+int QDaqLoopScheduler::workerOf(QDaqLoop *loop)
+{
+    QMutexLocker L(&mutex_);
+    return loopWorker_.value(loop, -1);
+}
+
+const void* QDaqLoopScheduler::groupDomain(const QString &name)
+{
+    QMutexLocker L(&mutex_);
+    return &groups_[name];
+}
+
+void QDaqLoopScheduler::unschedule(QDaqLoop *loop)
+{
+    QMutexLocker M(&migrate_);
+    Worker* w = 0;
+    {
+        QMutexLocker L(&mutex_);
+
+        if (!loopWorker_.contains(loop)) return;
+
+        w = workers_[loopWorker_.take(loop)];
+        w->load--;
+
+        foreach(const void* d, loopDomains_.take(loop))
+        {
+            if (--domains_[d].refs == 0) domains_.remove(d);
+        }
+    }
+
+    w->remove(loop);
+}
+
+//////////////////// Worker //////////////////////////////////////////
+
+QDaqLoopScheduler::Worker::Worker() : current_(0), quit_(false), load(0)
+{
+}
+
+void QDaqLoopScheduler::Worker::add(QDaqLoop *loop, qint64 period, qint64 start)
+{
+    Task t;
+    t.period = period;
+    t.deadline = start ? start : QDaqTimeValue::monotonicNs() + period;
+    t.loop = loop;
+    add(t);
+}
+
+void QDaqLoopScheduler::Worker::add(const Task &t)
+{
+    QMutexLocker L(&mutex_);
+    heap_.push_back(t);
+    std::push_heap(heap_.begin(), heap_.end());
+    wakeup_.wakeOne();
+}
+
+void QDaqLoopScheduler::Worker::remove(QDaqLoop *loop)
+{
+    Task t;
+    take(loop, t);
+}
+
+bool QDaqLoopScheduler::Worker::take(QDaqLoop *loop, Task &t)
+{
+    QMutexLocker L(&mutex_);
+    bool found = false;
+    for(std::vector<Task>::iterator it = heap_.begin(); it!=heap_.end(); ++it)
+    {
+        if (it->loop==loop)
+        {
+            t = *it;
+            found = true;
+            heap_.erase(it);
+            std::make_heap(heap_.begin(), heap_.end());
+            break;
+        }
+    }
+    // wait for a running iteration to finish
+    while (current_==loop) done_.wait(&mutex_);
+    wakeup_.wakeOne();
+    return found;
+}
+
+void QDaqLoopScheduler::Worker::stop()
+{
+    {
+        QMutexLocker L(&mutex_);
+        quit_ = true;
+        wakeup_.wakeOne();
+    }
+    wait();
+}
+
+void QDaqLoopScheduler::Worker::run()
+{
+    QMutexLocker L(&mutex_);
+    while (!quit_)
+    {
+        if (heap_.empty())
+        {
+            wakeup_.wait(&mutex_);
+            continue;
+        }
+
+        qint64 now = QDaqTimeValue::monotonicNs();
+        qint64 dt = heap_.front().deadline - now;
+        if (dt > 0)
+        {
+            // round up to the next ms
+            wakeup_.wait(&mutex_, (unsigned long)((dt + 999999)/1000000));
+            continue;
+        }
+
+        // pop the expired task and compute its next deadline
+        std::pop_heap(heap_.begin(), heap_.end());
+        Task& t = heap_.back();
+        t.deadline += t.period;
+        // skip missed repetitions but keep the phase
+        if (t.deadline <= now)
+            t.deadline += ((now - t.deadline)/t.period + 1)*t.period;
+        current_ = t.loop;
+        std::push_heap(heap_.begin(), heap_.end());
+
+        L.unlock();
+        QDaqLoopScheduler::execLoop(current_);
+        L.relock();
+        current_ = 0;
+        done_.wakeAll();
+    }
+}
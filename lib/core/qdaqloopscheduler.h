@@ -0,0 +1,139 @@
+#ifndef QDAQLOOPSCHEDULER_H
+#define QDAQLOOPSCHEDULER_H
+
+#include "QDaqGlobal.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <vector>
+#include <map>
+
+class QDaqLoop;
+
+/**
+ * @brief A shared pool of worker threads that executes top level loops.
+ *
+ * By default each top level QDaqLoop spawns its own QTimerThread. When a
+ * large number of slow loops is used this leads to many threads that
+ * mostly sleep.
+ *
+ * QDaqLoopScheduler offers an alternative execution model. It maintains
+ * a fixed number of worker threads (equal to QThread::idealThreadCount()).
+ * Each worker keeps a heap of loop deadlines on the monotonic clock and
+ * executes the loop with the earliest deadline when it expires.
+ *
+ * Loops are assigned to workers when they are scheduled. Loops that share
+ * a lock domain (see QDaqJob::lockDomain()), e.g., they talk to devices on
+ * the same QDaqInterface, are always assigned to the same worker so that
+ * they never contend for the interface lock. Otherwise the worker with the
+ * least number of loops is selected. If a new loop joins domains that are
+ * served by different workers, all loops connected through these domains
+ * are migrated to one worker, so that a lock domain is always served by a
+ * single thread.
+ *
+ * Loops can also share a named lock domain, see QDaqLoop::lockGroup.
+ *
+ * A loop is executed by the scheduler if its QDaqLoop::pooled property is set.
+ *
+ * @ingroup Core
+ */
+class QDAQ_EXPORT QDaqLoopScheduler
+{
+public:
+    /// Return the one-and-only scheduler object.
+    static QDaqLoopScheduler* instance();
+
+    /// Number of worker threads in the pool.
+    int workerCount() const { return workers_.size(); }
+
+    /**
+     * @brief Schedule a loop for periodic execution.
+     *
+     * @param loop The top level loop.
+     * @param period Repetition period in ms.
+     * @param domains Lock domains of the jobs in the loop.
+     * @param start Time of the first execution on the monotonic clock
+     * (QDaqTimeValue::monotonicNs()). If 0, one period from now.
+     */
+    void schedule(QDaqLoop* loop, uint period, const QList<const void*>& domains, qint64 start = 0);
+
+    /**
+     * @brief Remove a loop from the scheduler.
+     *
+     * If the loop is currently executing, the function blocks
+     * until execution is finished.
+     */
+    void unschedule(QDaqLoop* loop);
+
+    /// Index of the worker executing loop, -1 if the loop is not scheduled.
+    int workerOf(QDaqLoop* loop);
+
+    /// Return the lock domain of a named group.
+    const void* groupDomain(const QString& name);
+
+private:
+    QDaqLoopScheduler();
+    ~QDaqLoopScheduler();
+
+    // executes one iteration of a loop
+    static void execLoop(QDaqLoop* loop);
+
+    struct Task
+    {
+        qint64 deadline; // ns on the monotonic clock
+        qint64 period; // ns
+        QDaqLoop* loop;
+        // ordering for a min-heap on the deadline
+        bool operator<(const Task& rhs) const { return deadline > rhs.deadline; }
+    };
+
+    class Worker : public QThread
+    {
+        std::vector<Task> heap_;
+        QMutex mutex_;
+        QWaitCondition wakeup_, done_;
+        QDaqLoop* current_;
+        bool quit_;
+
+    protected:
+        virtual void run();
+
+    public:
+        Worker();
+
+        // number of loops served
+        int load;
+
+        void add(QDaqLoop* loop, qint64 period, qint64 start);
+        void add(const Task& t);
+        void remove(QDaqLoop* loop);
+        // remove a loop and return its task
+        bool take(QDaqLoop* loop, Task& t);
+        void stop();
+    };
+
+    struct Domain
+    {
+        int worker;
+        int refs;
+    };
+
+    QMutex mutex_;
+    // Serializes schedule() and unschedule(). Tasks are moved between
+    // workers outside mutex_, and no loop may be unscheduled meanwhile.
+    QMutex migrate_;
+    QVector<Worker*> workers_;
+    QHash<const void*, Domain> domains_;
+    QHash<QDaqLoop*, int> loopWorker_;
+    QHash<QDaqLoop*, QList<const void*> > loopDomains_;
+    // named lock domains, the addresses of the map values are the domains
+    std::map<QString, char> groups_;
+};
+
+#endif // QDAQLOOPSCHEDULER_H
@@ -1,6 +1,7 @@
 #include "qtimerthread.h"
+#include "QDaqTypes.h"
 
-QTimerThread::QTimerThread()
+QTimerThread::QTimerThread() : first_(0)
 {
     timer_.setInterval(1000);
     timer_.setTimerType(Qt::PreciseTimer);
@@ -16,6 +17,12 @@ QTimerThread::~QTimerThread()
 
 void QTimerThread::run()
 {
+    if (first_)
+    {
+        // start the timer one interval before the first timeout
+        qint64 dt = first_ - 1000000LL*interval() - QDaqTimeValue::monotonicNs();
+        if (dt > 0) usleep((unsigned long)(dt/1000));
+    }
 
     timer_.start();
     QThread::run();
@@ -32,6 +32,7 @@ class QTimerThread : public QThread
     Q_PROPERTY(int interval READ interval WRITE setInterval)
 
     QTimer timer_;
+    qint64 first_;
 
 protected slots:
     virtual void timer_func() {}
@@ -47,6 +48,10 @@ public:
     int interval() const { return timer_.interval(); }
     void setInterval(int ms) { timer_.setInterval(ms); }
 
+    /// Time of the first timeout on the monotonic clock (QDaqTimeValue::monotonicNs()).
+    /// If 0 (default) the first timeout occurs one interval after start().
+    void setFirstTimeout(qint64 ns) { first_ = ns; }
+
 };
 
 #endif // QTIMERTHREAD_H
@@ -131,6 +131,13 @@ public:
 	virtual void checkError(const char* msg, int len) 
 	{ Q_UNUSED(msg); Q_UNUSED(len); }
 
+    /// Devices on the same QDaqInterface share its lock domain.
+    virtual const void* lockDomain() const
+    {
+        if (ifc_) return ifc_.data();
+        return this;
+    }
+
 	//
 	void forcedOffline(const QString& reason = QString());
 
@@ -38,6 +38,9 @@ CONFIG(debug, debug|release) {
 
 INCLUDEPATH += ./core ./gui ./daq
 
+# count heap allocations per loop repetition (see core/allocdiag.h)
+alloc_diagnostics: DEFINES += QDAQ_ALLOC_DIAGNOSTICS
+
 SOURCES += \
     core/QDaqSession.cpp \
     core/QDaqObject.cpp \
@@ -49,6 +52,9 @@ SOURCES += \
     gui/QConsoleWidget.cpp \
     core/QDaqLogFile.cpp \
     core/QDaqChannel.cpp \
+    core/QDaqChannelBank.cpp \
+    core/QDaqGenerator.cpp \
+    core/QDaqVirtualChannel.cpp \
     core/QDaqDataBuffer.cpp \
     gui/QDaqObjectController.cpp \
     gui/QDaqObjectBrowser.cpp \
@@ -66,6 +72,9 @@ SOURCES += \
     core/bytearrayprototype.cpp \
     core/QDaqFilter.cpp \
     core/qtimerthread.cpp \
+    core/qdaqloopscheduler.cpp \
+    core/allocdiag.cpp \
+    core/calibration.cpp \
     core/h5helper_v1_0.cpp \
     core/qdaqh5file.cpp \
     core/h5helper_v1_1.cpp \
@@ -81,10 +90,16 @@ HEADERS  += \
     core/QDaqJob.h \
     core/QDaqVector.h \
     core/math_util.h \
+    core/os_util.h \
+    core/allocdiag.h \
+    core/calibration.h \
     gui/QConsoleWidget.h \
     gui/QDaqConsole.h \
     core/QDaqLogFile.h \
     core/QDaqChannel.h \
+    core/QDaqChannelBank.h \
+    core/QDaqGenerator.h \
+    core/QDaqVirtualChannel.h \
     core/QDaqDataBuffer.h \
     gui/QDaqObjectBrowser.h \
     gui/QDaqObjectController.h \
@@ -104,6 +119,7 @@ HEADERS  += \
     core/bytearrayprototype.h \
     core/QDaqFilter.h \
     core/qtimerthread.h \
+    core/qdaqloopscheduler.h \
     core/qdaqplugin.h \
     core/h5helper_v1_0.h \
     core/qdaqh5file.h \
@@ -3,6 +3,14 @@
 #include "qdaqinterpolator.h"
 #include "qdaqpid.h"
 #include "qdaqlinearcorrelator.h"
+#include "qdaqiirfilter.h"
+#include "qdaqfirfilter.h"
+#include "qdaqspectrum.h"
+#include "qdaqlockin.h"
+#include "qdaqpidbank.h"
+#include "qdaqkalman.h"
+#include "qdaqquantile.h"
+#include "qdaqhistogram.h"
 
 
 FilterFactory::FilterFactory() : QObject()
@@ -16,5 +24,13 @@ QList<const QMetaObject *> FilterFactory::pluginClasses() const
     lst << &QDaqPid::staticMetaObject;
     lst << &QDaqInterpolator::staticMetaObject;
     lst << &QDaqLinearCorrelator::staticMetaObject;
+    lst << &QDaqIirFilter::staticMetaObject;
+    lst << &QDaqFirFilter::staticMetaObject;
+    lst << &QDaqSpectrum::staticMetaObject;
+    lst << &QDaqLockIn::staticMetaObject;
+    lst << &QDaqPidBank::staticMetaObject;
+    lst << &QDaqKalman::staticMetaObject;
+    lst << &QDaqQuantile::staticMetaObject;
+    lst << &QDaqHistogram::staticMetaObject;
     return lst;
 }
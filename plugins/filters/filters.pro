@@ -26,6 +26,10 @@ win32 {
 }
 
 
+# gcc vectorizes loops with a run-time trip count (the block loops
+# of the filters) only with the dynamic cost model
+*-g++*: QMAKE_CXXFLAGS_RELEASE += -ftree-vectorize -fvect-cost-model=dynamic
+
 TARGET = $$qtLibraryTarget(qdaqfilters)
 TEMPLATE = lib
 
@@ -39,7 +43,15 @@ SOURCES += filterfactory.cpp \
     qdaqfopdt.cpp \
     qdaqinterpolator.cpp \
     qdaqlinearcorrelator.cpp \
-    qdaqpid.cpp
+    qdaqpid.cpp \
+    qdaqiirfilter.cpp \
+    qdaqfirfilter.cpp \
+    qdaqspectrum.cpp \
+    qdaqlockin.cpp \
+    qdaqpidbank.cpp \
+    qdaqkalman.cpp \
+    qdaqquantile.cpp \
+    qdaqhistogram.cpp
 
 HEADERS += filterfactory.h\
         filters_global.h \
@@ -49,7 +61,16 @@ HEADERS += filterfactory.h\
     qdaqinterpolator.h \
     qdaqpid.h \
     relaytuner.h \
-    isa_pid.h
+    isa_pid.h \
+    iir_design.h \
+    qdaqiirfilter.h \
+    qdaqfirfilter.h \
+    qdaqspectrum.h \
+    qdaqlockin.h \
+    qdaqpidbank.h \
+    qdaqkalman.h \
+    qdaqquantile.h \
+    qdaqhistogram.h
 
 unix {
     target.path = $$[QT_INSTALL_PLUGINS]/qdaq
@@ -0,0 +1,182 @@
+#ifndef _IIR_DESIGN_H_
+#define _IIR_DESIGN_H_
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+/*
+ * Design of digital IIR filters as a cascade of second order sections.
+ *
+ * An analog low-pass prototype (Butterworth or Chebyshev type I) is
+ * transformed to the requested band in the s-plane and then mapped to
+ * the z-plane with the bilinear transform, with pre-warped band edges.
+ *
+ * Each section is stored as 6 coefficients b0 b1 b2 a0 a1 a2 (a0 = 1) of
+ *
+ *            b0 + b1 z^-1 + b2 z^-2
+ *   H(z) = --------------------------
+ *            a0 + a1 z^-1 + a2 z^-2
+ *
+ * which is the "sos" layout of scipy.signal.
+ */
+namespace iir_design {
+
+typedef std::complex<double> cplx;
+typedef std::vector<cplx> cvec;
+
+enum band_t { Lowpass, Highpass, Bandpass, Bandstop };
+enum proto_t { Butterworth, Chebyshev };
+
+// analog low-pass prototype with cut-off 1 rad/s: poles and gain
+inline void prototype(proto_t t, int n, double ripple, cvec& p, double& k)
+{
+    const double pi = 3.14159265358979323846;
+    p.clear();
+    if (t==Chebyshev)
+    {
+        double eps = std::sqrt(std::pow(10., 0.1*ripple) - 1.);
+        double mu = std::asinh(1./eps)/n;
+        for(int i=0; i<n; ++i)
+        {
+            double th = pi*(2*i + 1)/(2*n);
+            p.push_back(cplx(-std::sinh(mu)*std::sin(th), std::cosh(mu)*std::cos(th)));
+        }
+        cplx g(1.);
+        for(int i=0; i<n; ++i) g *= -p[i];
+        k = g.real();
+        if (n%2==0) k /= std::sqrt(1. + eps*eps);
+    }
+    else
+    {
+        for(int i=0; i<n; ++i)
+            p.push_back(std::exp(cplx(0., pi*(2*i + n + 1)/(2*n))));
+        k = 1.;
+    }
+}
+
+// group conjugate pairs and real roots in pairs for the sections.
+// Real roots are paired first with last after sorting.
+inline void pairRoots(const cvec& r, std::vector< std::pair<cplx,cplx> >& pairs, int nsec)
+{
+    const double tol = 1e-10;
+    std::vector<cplx> cpx;
+    std::vector<double> re;
+    for(unsigned int i=0; i<r.size(); ++i)
+    {
+        if (std::abs(r[i].imag()) <= tol*std::max(1., std::abs(r[i]))) re.push_back(r[i].real());
+        else if (r[i].imag() > 0.) cpx.push_back(r[i]);
+    }
+    std::sort(re.begin(), re.end());
+    pairs.clear();
+    for(unsigned int i=0; i<cpx.size(); ++i)
+        pairs.push_back(std::make_pair(cpx[i], std::conj(cpx[i])));
+    unsigned int i = 0, j = re.size();
+    while (j > i+1) { pairs.push_back(std::make_pair(cplx(re[i]), cplx(re[j-1]))); ++i; --j; }
+    // an unpaired real root: first order section, the second root at z=0
+    if (j > i) pairs.push_back(std::make_pair(cplx(re[i]), cplx(0.)));
+    while ((int)pairs.size() < nsec) pairs.push_back(std::make_pair(cplx(0.), cplx(0.)));
+}
+
+/*
+ * Design a filter of the given order (order of the prototype; band filters
+ * have twice as many poles). f1 is the cut-off frequency, f2 the upper band
+ * edge of band filters, fs the sampling frequency, all in Hz. ripple is the
+ * pass-band ripple of Chebyshev filters in dB.
+ *
+ * Returns false if the specification is invalid.
+ */
+inline bool design(band_t band, proto_t proto, int order, double f1, double f2,
+                   double ripple, double fs, std::vector<double>& sos)
+{
+    const double pi = 3.14159265358979323846;
+    bool isBand = band==Bandpass || band==Bandstop;
+    if (order < 1 || fs <= 0. || f1 <= 0. || f1 >= fs/2) return false;
+    if (isBand && (f2 <= f1 || f2 >= fs/2)) return false;
+    if (proto==Chebyshev && ripple <= 0.) return false;
+
+    cvec p, z;
+    double k;
+    prototype(proto, order, ripple, p, k);
+
+    // pre-warped analog frequencies
+    const double fs2 = 2.*fs;
+    double w1 = fs2*std::tan(pi*f1/fs);
+    double w2 = isBand ? fs2*std::tan(pi*f2/fs) : 0.;
+
+    cvec pa, za;
+    cplx g(1.);
+    switch(band)
+    {
+    case Lowpass:
+        for(int i=0; i<order; ++i) pa.push_back(w1*p[i]);
+        k *= std::pow(w1, order);
+        break;
+    case Highpass:
+        for(int i=0; i<order; ++i) { pa.push_back(w1/p[i]); za.push_back(0.); g *= -p[i]; }
+        k *= (1./g).real();
+        break;
+    case Bandpass:
+    {
+        double w0 = std::sqrt(w1*w2), bw = w2 - w1;
+        for(int i=0; i<order; ++i)
+        {
+            cplx q = p[i]*(bw/2), d = std::sqrt(q*q - w0*w0);
+            pa.push_back(q + d);
+            pa.push_back(q - d);
+            za.push_back(0.);
+        }
+        k *= std::pow(bw, order);
+        break;
+    }
+    case Bandstop:
+    {
+        double w0 = std::sqrt(w1*w2), bw = w2 - w1;
+        for(int i=0; i<order; ++i)
+        {
+            cplx q = (bw/2)/p[i], d = std::sqrt(q*q - w0*w0);
+            pa.push_back(q + d);
+            pa.push_back(q - d);
+            za.push_back(cplx(0., w0));
+            za.push_back(cplx(0., -w0));
+            g *= -p[i];
+        }
+        k *= (1./g).real();
+        break;
+    }
+    }
+
+    // bilinear transform
+    cvec pd, zd;
+    cplx num(1.), den(1.);
+    for(unsigned int i=0; i<za.size(); ++i) { zd.push_back((fs2 + za[i])/(fs2 - za[i])); num *= fs2 - za[i]; }
+    for(unsigned int i=0; i<pa.size(); ++i) { pd.push_back((fs2 + pa[i])/(fs2 - pa[i])); den *= fs2 - pa[i]; }
+    // zeros at infinity go to z = -1
+    while (zd.size() < pd.size()) zd.push_back(-1.);
+    k *= (num/den).real();
+
+    // second order sections
+    int nsec = (pd.size() + 1)/2;
+    std::vector< std::pair<cplx,cplx> > pp, zz;
+    pairRoots(pd, pp, nsec);
+    pairRoots(zd, zz, nsec);
+    sos.assign(6*nsec, 0.);
+    for(int s=0; s<nsec; ++s)
+    {
+        double* c = &sos[6*s];
+        c[0] = 1.;
+        c[1] = -(zz[s].first + zz[s].second).real();
+        c[2] = (zz[s].first*zz[s].second).real();
+        c[3] = 1.;
+        c[4] = -(pp[s].first + pp[s].second).real();
+        c[5] = (pp[s].first*pp[s].second).real();
+    }
+    // overall gain in the first section
+    for(int i=0; i<3; ++i) sos[i] *= k;
+    return true;
+}
+
+} // namespace iir_design
+
+#endif
@@ -0,0 +1,215 @@
+#include "qdaqfirfilter.h"
+
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+
+#include <algorithm>
+
+// dot product of contiguous arrays.
+// Independent partial sums let the compiler use SIMD registers
+static inline double dot(const double* a, const double* b, int n)
+{
+    double s0 = 0., s1 = 0., s2 = 0., s3 = 0.;
+    int k = 0;
+    for(; k+4<=n; k+=4)
+    {
+        s0 += a[k]*b[k];
+        s1 += a[k+1]*b[k+1];
+        s2 += a[k+2]*b[k+2];
+        s3 += a[k+3]*b[k+3];
+    }
+    for(; k<n; ++k) s0 += a[k]*b[k];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// smallest power of 2 >= n, at least 2
+static int fftSize(int n)
+{
+    int N = 2;
+    while (N < n) N <<= 1;
+    return N;
+}
+
+QDaqFirFilter::QDaqFirFilter(const QString& name) :
+    QDaqFilter(name),
+    clearSeq_(0),
+    useFft_(false),
+    maxTaps_(0),
+    nch_(0),
+    m_(0),
+    xlen_(0), mmax_(0)
+{
+    os::published<params_t>::editor p(params_);
+    p->taps.assign(1, 1.);
+    p->clearSeq = clearSeq_;
+    prepare(*p);
+}
+
+void QDaqFirFilter::prepare(params_t& p) const
+{
+    const std::vector<double>& h = p.taps;
+    p.hr.assign(h.rbegin(), h.rend());
+
+    p.nfft = 0;
+    p.hf.clear();
+    if (useFft_ && blockSize_ > 1)
+    {
+        p.nfft = fftSize(h.size() - 1 + blockSize_);
+        p.hf.assign(p.nfft, 0.);
+        std::copy(h.begin(), h.end(), p.hf.begin());
+        gsl_fft_real_radix2_transform(p.hf.data(), 1, p.nfft);
+    }
+}
+
+void QDaqFirFilter::adoptParams()
+{
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+
+    // the history is kept if the number of taps is the same.
+    // x_ was sized at arm, thus nothing is allocated here
+    int m = p.taps.size();
+    if (m != m_ || p.clearSeq != clearSeq_)
+    {
+        m_ = m;
+        clearSeq_ = p.clearSeq;
+        std::fill(x_.begin(), x_.end(), 0.);
+    }
+}
+
+bool QDaqFirFilter::filterinit()
+{
+    nch_ = inputChannels().size();
+    if (nch_==0)
+    {
+        throwScriptError("No input channels.");
+        return false;
+    }
+
+    // blockSize_ is known now
+    {
+        os::published<params_t>::editor p(params_);
+        prepare(*p);
+    }
+    params_.adopt();
+    const params_t& p = params_.current();
+    clearSeq_ = p.clearSeq;
+    m_ = p.taps.size();
+
+    mmax_ = std::max(m_, maxTaps_);
+    xlen_ = mmax_ - 1 + blockSize_;
+    x_.assign(nch_*xlen_, 0.);
+    work_.assign(p.nfft ? fftSize(xlen_) : 0, 0.);
+    return true;
+}
+
+bool QDaqFirFilter::filterblock(const double* vin, double* vout, int n)
+{
+    adoptParams();
+
+    const params_t& p = params_.current();
+    const int m = m_;
+    const int L = xlen_;
+
+    for(int i=0; i<nch_; ++i)
+    {
+        double* x = &x_[i*L];
+        double* y = vout + i*n;
+        std::copy(vin + i*n, vin + (i+1)*n, x + m - 1);
+
+        if (p.nfft && n > 1)
+        {
+            // overlap-save: the outputs m-1 ... m-2+n of the circular
+            // convolution are not affected by wrap-around
+            const int N = p.nfft;
+            double* w = work_.data();
+            const double* h = p.hf.data();
+            std::copy(x, x + m - 1 + n, w);
+            std::fill(w + m - 1 + n, w + N, 0.);
+            gsl_fft_real_radix2_transform(w, 1, N);
+            // product of halfcomplex arrays
+            w[0] *= h[0];
+            w[N/2] *= h[N/2];
+            for(int k=1; k<N/2; ++k)
+            {
+                double re = w[k], im = w[N-k];
+                w[k] = re*h[k] - im*h[N-k];
+                w[N-k] = re*h[N-k] + im*h[k];
+            }
+            gsl_fft_halfcomplex_radix2_inverse(w, 1, N);
+            std::copy(w + m - 1, w + m - 1 + n, y);
+        }
+        else
+        {
+            for(int j=0; j<n; ++j) y[j] = dot(p.hr.data(), x + j, m);
+        }
+
+        // keep the last m-1 samples
+        std::copy(x + n, x + n + m - 1, x);
+    }
+
+    return true;
+}
+
+QDaqVector QDaqFirFilter::taps() const
+{
+    const std::vector<double>& h = params_.staged().taps;
+    QDaqVector v;
+    v.push(h.data(), (int)h.size());
+    return v;
+}
+
+// setters
+void QDaqFirFilter::setTaps(const QDaqVector& v)
+{
+    if (v.isEmpty())
+    {
+        throwScriptError("At least one filter tap is needed.");
+        return;
+    }
+    if (armed() && v.size() > mmax_)
+    {
+        throwScriptError(QString("While armed the filter can have at most %1 taps.").arg(mmax_));
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        p->taps.assign(v.constData(), v.constData() + v.size());
+        prepare(*p);
+    }
+    emit propertiesChanged();
+}
+void QDaqFirFilter::setUseFft(bool on)
+{
+    if (throwIfArmed()) return;
+    if (useFft_ != on)
+    {
+        useFft_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqFirFilter::setMaxTaps(int n)
+{
+    if (throwIfArmed()) return;
+    if (n < 0)
+    {
+        throwScriptError("maxTaps must be >= 0.");
+        return;
+    }
+    if (maxTaps_ != n)
+    {
+        maxTaps_ = n;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqFirFilter::clear()
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->clearSeq++;
+    }
+    if (!armed()) std::fill(x_.begin(), x_.end(), 0.);
+    emit propertiesChanged();
+}
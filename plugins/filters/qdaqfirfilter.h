@@ -0,0 +1,101 @@
+#ifndef QDAQFIRFILTER_H
+#define QDAQFIRFILTER_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "QDaqVector.h"
+#include "os_util.h"
+
+#include <vector>
+
+/**
+ * @brief FIR digital filter with arbitrary taps.
+ *
+ * Filters any number of input channels with the same taps h[k];
+ * input channel i is filtered to output channel i:
+ *
+ *   y[t] = sum_k h[k] x[t-k],  k = 0 ... M-1
+ *
+ * Each channel keeps the last M-1 input samples in a linear buffer, so that
+ * every output is a dot product over contiguous memory, which the compiler
+ * vectorizes.
+ *
+ * In block mode with useFft set, each block is convolved by FFT
+ * (overlap-save, GSL radix-2 real transforms). This is faster for long
+ * kernels, i.e., when the number of taps is large compared to log2 of the
+ * block size.
+ *
+ * The taps can be changed while the loop runs. The reversed taps and the
+ * FFT of the kernel are computed by the setter, and the filter history is
+ * sized at arm for maxTaps, thus the loop thread never allocates. If the
+ * number of taps changes, the filter history is cleared.
+ */
+class FILTERSSHARED_EXPORT QDaqFirFilter :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// Filter taps h[0] ... h[M-1].
+    Q_PROPERTY(QDaqVector taps READ taps WRITE setTaps)
+    /// Use FFT convolution in block mode.
+    Q_PROPERTY(bool useFft READ useFft WRITE setUseFft)
+    /// Maximum number of taps while armed. If 0, the number of taps at arm.
+    Q_PROPERTY(int maxTaps READ maxTaps WRITE setMaxTaps)
+
+protected:
+    // taps adopted by the loop thread, with the quantities derived from
+    // them, which are computed in the setter thread.
+    // clear() is a command applied when clearSeq changes.
+    struct params_t {
+        std::vector<double> taps;
+        // taps in reverse order
+        std::vector<double> hr;
+        // FFT size (0 if not used) and transfer function (halfcomplex)
+        int nfft;
+        std::vector<double> hf;
+        uint clearSeq;
+    };
+    os::published<params_t> params_;
+    uint clearSeq_;
+    void adoptParams();
+    // compute hr, nfft and hf from the taps
+    void prepare(params_t& p) const;
+
+    bool useFft_;
+    int maxTaps_;
+    int nch_;
+    // number of taps in use
+    int m_;
+    // per channel: M-1 past samples followed by the current block.
+    // Sized at arm for the capacity mmax_
+    std::vector<double> x_;
+    int xlen_, mmax_;
+    // FFT work space, sized at arm
+    std::vector<double> work_;
+
+public:
+    Q_INVOKABLE explicit QDaqFirFilter(const QString& name);
+
+    // getters
+    virtual int nInputChannels() const { return inputChannels().size(); }
+    virtual int nOutputChannels() const { return inputChannels().size(); }
+    QDaqVector taps() const;
+    bool useFft() const { return useFft_; }
+    int maxTaps() const { return maxTaps_; }
+
+    // setters
+    void setTaps(const QDaqVector& v);
+    void setUseFft(bool on);
+    void setMaxTaps(int n);
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterblock(const double* vin, double* vout, int n);
+
+public slots:
+    /// Clear the filter history.
+    void clear();
+};
+
+#endif // QDAQFIRFILTER_H
@@ -7,10 +7,23 @@ QDaqFOPDT::QDaqFOPDT(const QString& name) :
     td_(10),
     y_(0.)
 {
+    os::published<params_t>::editor p(params_);
+    p->kp = kp_;
+    p->tp = tp_;
+}
+
+void QDaqFOPDT::adoptParams()
+{
+    if (!params_.adopt()) return;
+    kp_ = params_.current().kp;
+    tp_ = params_.current().tp;
+    h_ = tp_ ? exp(-1./tp_) : 1.0;
 }
 
 bool QDaqFOPDT::filterinit()
 {
+    adoptParams();
+
     ubuff.setCapacity(td_);
     ubuff.setCircular(true);
     for(uint i=0; i<td_; i++) ubuff << 0.;
@@ -22,6 +35,8 @@ bool QDaqFOPDT::filterinit()
 
 bool QDaqFOPDT::filterfunc(const double* vin, double* vout)
 {
+    adoptParams();
+
     ubuff << *vin;
     double u = ubuff[0];
 
@@ -33,19 +48,23 @@ bool QDaqFOPDT::filterfunc(const double* vin, double* vout)
 
 void QDaqFOPDT::setKp(double k)
 {
-    QMutexLocker L(&comm_lock);
-    kp_ = k;
+    {
+        os::published<params_t>::editor p(params_);
+        p->kp = k;
+    }
     emit propertiesChanged();
 }
 void QDaqFOPDT::setTp(uint t)
 {
-    QMutexLocker L(&comm_lock);
-    tp_ = t;
+    {
+        os::published<params_t>::editor p(params_);
+        p->tp = t;
+    }
     emit propertiesChanged();
 }
 void QDaqFOPDT::setTd(uint t)
 {
-    QMutexLocker L(&comm_lock);
+    JobLocker L(this);
     td_ = t;
     filterinit();
     emit propertiesChanged();
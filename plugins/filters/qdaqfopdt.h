@@ -5,6 +5,7 @@
 
 #include "QDaqFilter.h"
 #include "QDaqVector.h"
+#include "os_util.h"
 
 class FILTERSSHARED_EXPORT QDaqFOPDT :
         public QDaqFilter
@@ -26,14 +27,22 @@ class FILTERSSHARED_EXPORT QDaqFOPDT :
     QDaqVector ubuff;
     uint ibuff;
 
+    // on-line parameters, adopted in filterfunc()
+    struct params_t {
+        double kp;
+        uint tp;
+    };
+    os::published<params_t> params_;
+    void adoptParams();
+
 public:
     Q_INVOKABLE explicit QDaqFOPDT(const QString& name);
 
     // getters
     virtual int nInputChannels() const { return 1; }
     virtual int nOutputChannels() const { return 1; }
-    double kp() const { return kp_; }
-    uint tp() const { return tp_; }
+    double kp() const { return params_.staged().kp; }
+    uint tp() const { return params_.staged().tp; }
     uint td() const { return td_; }
 
     // setters
@@ -0,0 +1,323 @@
+#include "qdaqhistogram.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QDaqHistogram::QDaqHistogram(const QString& name) :
+    QDaqFilter(name),
+    bins_(100),
+    min_(0.), max_(1.),
+    binning_(Linear),
+    clearSeq_(0),
+    x0_(0.), scale_(1.),
+    w_(1.), g_(1.),
+    under_(0.), over_(0.), total_(0.)
+{
+    results_t r;
+    r.under = r.over = r.total = 0.;
+    r.w = 1.;
+    out_.reset(r);
+    os::published<params_t>::editor p(params_);
+    p->ff = 1.;
+    p->clearSeq = clearSeq_;
+}
+
+void QDaqHistogram::adoptParams()
+{
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+
+    g_ = 1./p.ff;
+    if (p.clearSeq != clearSeq_)
+    {
+        clearSeq_ = p.clearSeq;
+        std::fill(counts_.begin(), counts_.end(), 0.);
+        under_ = over_ = total_ = 0.;
+        w_ = 1.;
+    }
+}
+
+// setters
+void QDaqHistogram::setBins(uint n)
+{
+    if (throwIfArmed()) return;
+    if (n < 1)
+    {
+        throwScriptError("bins must be at least 1.");
+        return;
+    }
+    if (bins_ != n)
+    {
+        bins_ = n;
+        emit propertiesChanged();
+    }
+}
+void QDaqHistogram::setMinimum(double v)
+{
+    if (throwIfArmed()) return;
+    if (min_ != v)
+    {
+        min_ = v;
+        emit propertiesChanged();
+    }
+}
+void QDaqHistogram::setMaximum(double v)
+{
+    if (throwIfArmed()) return;
+    if (max_ != v)
+    {
+        max_ = v;
+        emit propertiesChanged();
+    }
+}
+void QDaqHistogram::setBinning(BinningType b)
+{
+    if (throwIfArmed()) return;
+    if ((int)b==-1)
+    {
+        throwScriptError("Invalid binning specification. Availiable options: "
+                         "Linear, Logarithmic");
+        return;
+    }
+    if (binning_ != b)
+    {
+        binning_ = b;
+        emit propertiesChanged();
+    }
+}
+void QDaqHistogram::setForgettingFactor(double v)
+{
+    if (!(v > 0. && v <= 1.))
+    {
+        throwScriptError("forgettingFactor must be in (0, 1].");
+        return;
+    }
+    if (params_.staged().ff != v)
+    {
+        {
+            os::published<params_t>::editor p(params_);
+            p->ff = v;
+        }
+        emit propertiesChanged();
+    }
+}
+
+bool QDaqHistogram::filterinit()
+{
+    if (!(max_ > min_))
+    {
+        throwScriptError("maximum must be larger than minimum.");
+        return false;
+    }
+    if (binning_==Logarithmic)
+    {
+        if (!(min_ > 0.))
+        {
+            throwScriptError("minimum must be > 0 for Logarithmic binning.");
+            return false;
+        }
+        x0_ = std::log(min_);
+        scale_ = bins_/(std::log(max_) - x0_);
+    }
+    else
+    {
+        x0_ = min_;
+        scale_ = bins_/(max_ - min_);
+    }
+    params_.adopt();
+    const params_t& p = params_.current();
+    g_ = 1./p.ff;
+    clearSeq_ = p.clearSeq;
+
+    counts_.assign(bins_, 0.);
+    under_ = over_ = total_ = 0.;
+    w_ = 1.;
+    {
+        QMutexLocker L(&readLock_);
+        results_t r;
+        r.counts = counts_;
+        r.under = r.over = r.total = 0.;
+        r.w = 1.;
+        out_.reset(r);
+    }
+    return true;
+}
+
+// divide all counts by the current weight, to avoid overflow
+void QDaqHistogram::rescale()
+{
+    const double s = 1./w_;
+    for(uint i=0; i<bins_; ++i) counts_[i] *= s;
+    under_ *= s;
+    over_ *= s;
+    total_ *= s;
+    w_ = 1.;
+}
+
+// copy the results to the back buffer, sized at arm, and publish them.
+// The back buffer may hold any earlier repetition, thus all bins are copied.
+void QDaqHistogram::publishResults()
+{
+    results_t& r = out_.back();
+    std::copy(counts_.begin(), counts_.end(), r.counts.begin());
+    r.under = under_;
+    r.over = over_;
+    r.total = total_;
+    r.w = w_;
+    out_.publish();
+}
+
+// call with readLock_ held
+const QDaqHistogram::results_t& QDaqHistogram::results() const
+{
+    out_.update();
+    return out_.read();
+}
+
+bool QDaqHistogram::filterblock(const double* vin, double* vout, int n)
+{
+    Q_UNUSED(vout);
+
+    adoptParams();
+
+    const bool lg = binning_==Logarithmic;
+    const double x0 = x0_, scale = scale_, g = g_;
+    const double nb = bins_;
+    double* c = counts_.data();
+    double w = w_;
+    for(int j=0; j<n; ++j)
+    {
+        double x = vin[j];
+        if (!std::isfinite(x)) continue;
+        w *= g;
+        total_ += w;
+        if (lg)
+        {
+            if (x <= 0.) { under_ += w; continue; }
+            x = std::log(x);
+        }
+        double u = (x - x0)*scale;
+        if (u < 0.) under_ += w;
+        else if (u >= nb) over_ += w;
+        else c[(uint)u] += w;
+        if (w > 1e100)
+        {
+            w_ = w;
+            rescale();
+            w = w_;
+        }
+    }
+    w_ = w;
+
+    publishResults();
+    return true;
+}
+
+void QDaqHistogram::clear()
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->clearSeq++;
+    }
+    if (!armed())
+    {
+        std::fill(counts_.begin(), counts_.end(), 0.);
+        under_ = over_ = total_ = 0.;
+        w_ = 1.;
+        QMutexLocker L(&readLock_);
+        publishResults();
+    }
+    emit propertiesChanged();
+}
+
+// getters
+double QDaqHistogram::edge(uint i) const
+{
+    if (binning_==Logarithmic)
+        return min_*std::pow(max_/min_, double(i)/bins_);
+    return min_ + (max_ - min_)*i/bins_;
+}
+QDaqVector QDaqHistogram::edges() const
+{
+    QDaqVector v;
+    for(uint i=0; i<=bins_; ++i) v.push(edge(i));
+    return v;
+}
+QDaqVector QDaqHistogram::centers() const
+{
+    QDaqVector v;
+    for(uint i=0; i<bins_; ++i)
+    {
+        double a = edge(i), b = edge(i+1);
+        v.push(binning_==Logarithmic ? std::sqrt(a*b) : 0.5*(a + b));
+    }
+    return v;
+}
+QDaqVector QDaqHistogram::counts() const
+{
+    QMutexLocker L(&readLock_);
+    const results_t& r = results();
+    QDaqVector v;
+    const double s = 1./r.w;
+    for(uint i=0; i<r.counts.size(); ++i) v.push(r.counts[i]*s);
+    return v;
+}
+double QDaqHistogram::underflow() const
+{
+    QMutexLocker L(&readLock_);
+    const results_t& r = results();
+    return r.under/r.w;
+}
+double QDaqHistogram::overflow() const
+{
+    QMutexLocker L(&readLock_);
+    const results_t& r = results();
+    return r.over/r.w;
+}
+double QDaqHistogram::total() const
+{
+    QMutexLocker L(&readLock_);
+    const results_t& r = results();
+    return r.total/r.w;
+}
+
+double QDaqHistogram::quantile(double p) const
+{
+    if (!(p >= 0. && p <= 1.))
+    {
+        const_cast<QDaqHistogram*>(this)->throwScriptError("p must be in [0, 1].");
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // the sum runs outside the lock, on a copy
+    std::vector<double> counts;
+    double under, total;
+    {
+        QMutexLocker L(&readLock_);
+        const results_t& r = results();
+        counts = r.counts;
+        under = r.under;
+        total = r.total;
+    }
+    if (counts.empty() || total <= 0.) return std::numeric_limits<double>::quiet_NaN();
+
+    double target = p*total;
+    double s = under;
+    if (target <= s) return min_;
+    for(uint i=0; i<counts.size(); ++i)
+    {
+        double c = counts[i];
+        if (c > 0. && s + c >= target)
+        {
+            // interpolate within the bin
+            double f = (target - s)/c;
+            double a = edge(i), b = edge(i+1);
+            return binning_==Logarithmic ? a*std::pow(b/a, f) : a + f*(b - a);
+        }
+        s += c;
+    }
+    return max_;
+}
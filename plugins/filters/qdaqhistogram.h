@@ -0,0 +1,143 @@
+#ifndef QDAQHISTOGRAM_H
+#define QDAQHISTOGRAM_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "QDaqVector.h"
+#include "os_util.h"
+
+#include <QMutex>
+
+#include <vector>
+
+/**
+ * @brief Streaming histogram.
+ *
+ * Counts the samples of one input channel in bins equally spaced
+ * between minimum and maximum (binning = Linear) or equally spaced in
+ * log scale (binning = Logarithmic, minimum > 0). Values outside the
+ * range are counted in underflow and overflow. Non-finite values are
+ * ignored. There are no output channels.
+ *
+ * If forgettingFactor < 1 the older samples decay: a sample that is k
+ * samples old contributes forgettingFactor^k. The decay is not applied to
+ * the bins at each sample; instead the weight of new samples grows by
+ * 1/forgettingFactor and the bins are divided by it when read, so the
+ * cost per sample is constant.
+ *
+ * centers and counts can be passed directly to QDaqPlotWidget::plot().
+ *
+ * The binning can be changed only when the histogram is not armed;
+ * forgettingFactor and clear() take effect at the next repetition of the
+ * loop. The results are published by the loop thread once per repetition
+ * through a triple buffer, without locking; the getters read this copy.
+ */
+class FILTERSSHARED_EXPORT QDaqHistogram :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// Number of bins.
+    Q_PROPERTY(uint bins READ bins WRITE setBins)
+    /// Lower edge of the first bin.
+    Q_PROPERTY(double minimum READ minimum WRITE setMinimum)
+    /// Upper edge of the last bin.
+    Q_PROPERTY(double maximum READ maximum WRITE setMaximum)
+    /// Bin spacing: Linear or Logarithmic.
+    Q_PROPERTY(BinningType binning READ binning WRITE setBinning)
+    /// Decay per sample, 0 < forgettingFactor <= 1 (1 = no decay).
+    Q_PROPERTY(double forgettingFactor READ forgettingFactor WRITE setForgettingFactor)
+    /// Bin edges, bins+1 values (read-only).
+    Q_PROPERTY(QDaqVector edges READ edges)
+    /// Bin centers (geometric for Logarithmic binning) (read-only).
+    Q_PROPERTY(QDaqVector centers READ centers)
+    /// Bin counts (read-only).
+    Q_PROPERTY(QDaqVector counts READ counts)
+    /// Count below minimum (read-only).
+    Q_PROPERTY(double underflow READ underflow)
+    /// Count above maximum (read-only).
+    Q_PROPERTY(double overflow READ overflow)
+    /// Total count including under/overflow (read-only).
+    Q_PROPERTY(double total READ total)
+
+public:
+    enum BinningType {
+        Linear,
+        Logarithmic
+    };
+    Q_ENUM(BinningType)
+
+protected:
+    uint bins_;
+    double min_, max_;
+    BinningType binning_;
+
+    // parameters that can change while armed
+    struct params_t {
+        double ff;
+        uint clearSeq;
+    };
+    os::published<params_t> params_;
+    uint clearSeq_;
+    void adoptParams();
+
+    // bin index = (x - x0_)*scale_, x in log for Logarithmic
+    double x0_, scale_;
+    // weight of the next sample and its growth per sample
+    double w_, g_;
+    std::vector<double> counts_;
+    double under_, over_, total_;
+
+    void rescale();
+    double edge(uint i) const;
+
+    // results published by the loop thread, not yet divided by w.
+    // The loop never waits; readLock_ only serializes the readers.
+    struct results_t {
+        std::vector<double> counts;
+        double under, over, total, w;
+    };
+    mutable os::triple_buffer<results_t> out_;
+    mutable QMutex readLock_;
+    void publishResults();
+    const results_t& results() const;
+
+public:
+    Q_INVOKABLE explicit QDaqHistogram(const QString& name);
+
+    // getters
+    virtual int nInputChannels() const { return 1; }
+    virtual int nOutputChannels() const { return 0; }
+    uint bins() const { return bins_; }
+    double minimum() const { return min_; }
+    double maximum() const { return max_; }
+    BinningType binning() const { return binning_; }
+    double forgettingFactor() const { return params_.staged().ff; }
+    QDaqVector edges() const;
+    QDaqVector centers() const;
+    QDaqVector counts() const;
+    double underflow() const;
+    double overflow() const;
+    double total() const;
+
+    // setters
+    void setBins(uint n);
+    void setMinimum(double v);
+    void setMaximum(double v);
+    void setBinning(BinningType b);
+    void setForgettingFactor(double v);
+
+    /// Quantile at probability p, interpolated within the bins.
+    Q_INVOKABLE double quantile(double p) const;
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterblock(const double* vin, double* vout, int n);
+
+public slots:
+    /// Reset all counts to zero.
+    void clear();
+};
+
+#endif // QDAQHISTOGRAM_H
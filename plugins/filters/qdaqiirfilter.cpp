@@ -0,0 +1,265 @@
+#include "qdaqiirfilter.h"
+#include "iir_design.h"
+
+#include <algorithm>
+
+QDaqIirFilter::QDaqIirFilter(const QString& name) :
+    QDaqFilter(name),
+    type_(Lowpass),
+    design_(Butterworth),
+    order_(2),
+    f1_(1.), f2_(2.), ripple_(1.), fs_(0.),
+    loopRate_(0.),
+    clearSeq_(0),
+    nch_(0),
+    ns_(0), maxSections_(0)
+{
+    os::published<params_t>::editor p(params_);
+    p->clearSeq = clearSeq_;
+}
+
+bool QDaqIirFilter::redesign()
+{
+    if (design_==Custom) return true;
+    double fs = fs_ > 0. ? fs_ : loopRate_;
+    // not known before arm
+    if (fs <= 0.) return true;
+
+    std::vector<double> sos;
+    bool ok = iir_design::design((iir_design::band_t)type_, (iir_design::proto_t)design_,
+                                 order_, f1_, f2_, ripple_, fs, sos);
+    if (ok) publish(sos);
+    return ok;
+}
+
+void QDaqIirFilter::publish(const std::vector<double>& sos)
+{
+    os::published<params_t>::editor p(params_);
+    p->sos = sos;
+}
+
+void QDaqIirFilter::adoptParams()
+{
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+
+    // the number of sections changed: restart from 0.
+    // z_ was sized at arm, thus nothing is allocated here
+    int ns = p.sos.size()/6;
+    if (ns != ns_ || p.clearSeq != clearSeq_)
+    {
+        ns_ = ns;
+        clearSeq_ = p.clearSeq;
+        std::fill(z_.begin(), z_.end(), 0.);
+    }
+}
+
+bool QDaqIirFilter::filterinit()
+{
+    nch_ = inputChannels().size();
+    if (nch_==0)
+    {
+        throwScriptError("No input channels.");
+        return false;
+    }
+
+    loopRate_ = top_ && top_->period() ? 1000.*blockSize_/top_->period() : 0.;
+    if (!redesign() || sections()==0)
+    {
+        throwScriptError("Invalid filter specification.");
+        return false;
+    }
+
+    params_.adopt();
+    const params_t& p = params_.current();
+    clearSeq_ = p.clearSeq;
+    ns_ = p.sos.size()/6;
+    // a designed filter has at most 2*order = 32 poles
+    maxSections_ = std::max(ns_, 16);
+    z_.assign(2*maxSections_*nch_, 0.);
+    return true;
+}
+
+bool QDaqIirFilter::filterblock(const double* vin, double* vout, int n)
+{
+    adoptParams();
+
+    const std::vector<double>& sos = params_.current().sos;
+    const int ns = ns_;
+    const int nc = nch_;
+
+    std::copy(vin, vin + nc*n, vout);
+
+    if (n==1)
+    {
+        // one sample: the inner loop runs over the channels
+        for(int s=0; s<ns; ++s)
+        {
+            const double* c = &sos[6*s];
+            const double b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[4], a2 = c[5];
+            double* z = &z_[2*s*nc];
+            for(int i=0; i<nc; ++i)
+            {
+                double x = vout[i];
+                double y = b0*x + z[2*i];
+                z[2*i] = b1*x - a1*y + z[2*i+1];
+                z[2*i+1] = b2*x - a2*y;
+                vout[i] = y;
+            }
+        }
+    }
+    else
+    {
+        // a block: each section runs over the samples of a channel
+        for(int i=0; i<nc; ++i)
+        {
+            double* y = vout + i*n;
+            for(int s=0; s<ns; ++s)
+            {
+                const double* c = &sos[6*s];
+                const double b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[4], a2 = c[5];
+                double* z = &z_[2*(s*nc + i)];
+                double z1 = z[0], z2 = z[1];
+                for(int j=0; j<n; ++j)
+                {
+                    double x = y[j];
+                    double v = b0*x + z1;
+                    z1 = b1*x - a1*v + z2;
+                    z2 = b2*x - a2*v;
+                    y[j] = v;
+                }
+                z[0] = z1;
+                z[1] = z2;
+            }
+        }
+    }
+
+    return true;
+}
+
+QDaqVector QDaqIirFilter::sos() const
+{
+    const std::vector<double>& c = params_.staged().sos;
+    QDaqVector v;
+    v.push(c.data(), (int)c.size());
+    return v;
+}
+
+// setters
+void QDaqIirFilter::setType(FilterType t)
+{
+    if ((int)t==-1)
+    {
+        throwScriptError("Invalid filter type. Availiable options: "
+                         "Lowpass, Highpass, Bandpass, Bandstop");
+        return;
+    }
+    if (type_ == t) return;
+    type_ = t;
+    if (!redesign() && armed())
+        throwScriptError("Invalid filter specification.");
+    emit propertiesChanged();
+}
+void QDaqIirFilter::setDesign(FilterDesign d)
+{
+    if ((int)d==-1)
+    {
+        throwScriptError("Invalid filter design. Availiable options: "
+                         "Butterworth, Chebyshev, Custom");
+        return;
+    }
+    if (design_ == d) return;
+    design_ = d;
+    if (!redesign() && armed())
+        throwScriptError("Invalid filter specification.");
+    emit propertiesChanged();
+}
+void QDaqIirFilter::setOrder(int n)
+{
+    if (order_ == n) return;
+    if (n<1 || n>16)
+    {
+        throwScriptError("Filter order must be between 1 and 16.");
+        return;
+    }
+    order_ = n;
+    if (!redesign() && armed())
+        throwScriptError("Invalid filter specification.");
+    emit propertiesChanged();
+}
+void QDaqIirFilter::setFrequency(double f)
+{
+    if (f1_ == f) return;
+    f1_ = f;
+    if (!redesign() && armed())
+        throwScriptError("Invalid filter specification.");
+    emit propertiesChanged();
+}
+void QDaqIirFilter::setFrequency2(double f)
+{
+    if (f2_ == f) return;
+    f2_ = f;
+    if (!redesign() && armed())
+        throwScriptError("Invalid filter specification.");
+    emit propertiesChanged();
+}
+void QDaqIirFilter::setRipple(double r)
+{
+    if (ripple_ == r) return;
+    ripple_ = r;
+    if (!redesign() && armed())
+        throwScriptError("Invalid filter specification.");
+    emit propertiesChanged();
+}
+void QDaqIirFilter::setSamplingRate(double f)
+{
+    if (fs_ == f) return;
+    if (f < 0.)
+    {
+        throwScriptError("Sampling rate must be >= 0.");
+        return;
+    }
+    fs_ = f;
+    if (!redesign() && armed())
+        throwScriptError("Invalid filter specification.");
+    emit propertiesChanged();
+}
+void QDaqIirFilter::setSos(const QDaqVector& v)
+{
+    int n = v.size();
+    if (n==0 || n%6)
+    {
+        throwScriptError("sos must contain 6 coefficients per section.");
+        return;
+    }
+    if (armed() && n/6 > maxSections_)
+    {
+        throwScriptError(QString("While armed sos can have at most %1 sections.").arg(maxSections_));
+        return;
+    }
+    std::vector<double> sos(v.constData(), v.constData() + n);
+    for(int s=0; s<n/6; ++s)
+    {
+        double* c = &sos[6*s];
+        if (c[3]==0.)
+        {
+            throwScriptError("a0 must be non-zero.");
+            return;
+        }
+        for(int i=0; i<6; ++i) if (i!=3) c[i] /= c[3];
+        c[3] = 1.;
+    }
+    design_ = Custom;
+    publish(sos);
+    emit propertiesChanged();
+}
+
+void QDaqIirFilter::clear()
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->clearSeq++;
+    }
+    if (!armed()) std::fill(z_.begin(), z_.end(), 0.);
+    emit propertiesChanged();
+}
@@ -0,0 +1,138 @@
+#ifndef QDAQIIRFILTER_H
+#define QDAQIIRFILTER_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "QDaqVector.h"
+#include "os_util.h"
+
+#include <vector>
+
+/**
+ * @brief IIR digital filter, a cascade of second order sections.
+ *
+ * Filters any number of input channels with the same coefficients; input
+ * channel i is filtered to output channel i.
+ *
+ * The filter is designed from an analog Butterworth or Chebyshev (type I)
+ * prototype with the bilinear transform. Low/high-pass filters have
+ * order poles and cut-off frequency; band-pass/stop filters have 2*order
+ * poles and band edges frequency, frequency2. A notch is a first order
+ * Bandstop filter.
+ *
+ * Alternatively the sections can be set directly with the sos property
+ * (design becomes Custom).
+ *
+ * The sampling rate is taken from the top loop (1000*blockSize/period)
+ * unless the samplingRate property is set. The design can be changed
+ * while the loop runs; the new coefficients are adopted at the next
+ * repetition. The filter state is sized at arm for the largest design
+ * (16 sections) or the current sos, whichever is larger; while armed,
+ * sos cannot have more sections than that.
+ */
+class FILTERSSHARED_EXPORT QDaqIirFilter :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// Band type: Lowpass, Highpass, Bandpass, Bandstop.
+    Q_PROPERTY(FilterType type READ type WRITE setType)
+    /// Prototype: Butterworth, Chebyshev or Custom (coefficients given in sos).
+    Q_PROPERTY(FilterDesign design READ design WRITE setDesign)
+    /// Order of the prototype filter.
+    Q_PROPERTY(int order READ order WRITE setOrder)
+    /// Cut-off frequency or lower band edge in Hz.
+    Q_PROPERTY(double frequency READ frequency WRITE setFrequency)
+    /// Upper band edge in Hz of Bandpass/Bandstop filters.
+    Q_PROPERTY(double frequency2 READ frequency2 WRITE setFrequency2)
+    /// Pass-band ripple in dB of Chebyshev filters.
+    Q_PROPERTY(double ripple READ ripple WRITE setRipple)
+    /// Sampling rate in Hz. If 0 the sampling rate of the loop is used.
+    Q_PROPERTY(double samplingRate READ samplingRate WRITE setSamplingRate)
+    /// Filter sections, 6 coefficients b0 b1 b2 a0 a1 a2 per section.
+    Q_PROPERTY(QDaqVector sos READ sos WRITE setSos)
+    /// Number of second order sections.
+    Q_PROPERTY(int sections READ sections)
+
+public:
+    enum FilterType {
+        Lowpass,
+        Highpass,
+        Bandpass,
+        Bandstop
+    };
+    Q_ENUM(FilterType)
+
+    enum FilterDesign {
+        Butterworth,
+        Chebyshev,
+        Custom
+    };
+    Q_ENUM(FilterDesign)
+
+protected:
+    FilterType type_;
+    FilterDesign design_;
+    int order_;
+    double f1_, f2_, ripple_, fs_;
+    // sampling rate of the loop, set at arm
+    double loopRate_;
+
+    // coefficients adopted by the loop thread, a0 normalized to 1.
+    // clear() is a command applied when clearSeq changes.
+    struct params_t {
+        std::vector<double> sos;
+        uint clearSeq;
+    };
+    os::published<params_t> params_;
+    uint clearSeq_;
+    void adoptParams();
+
+    // section states, z_[2*(s*nch_ + c) + 0/1] for section s, channel c.
+    // Sized at arm for maxSections_
+    std::vector<double> z_;
+    int nch_;
+    // sections in use and the capacity of z_
+    int ns_, maxSections_;
+
+    // recalculate the sections from the design properties
+    bool redesign();
+    void publish(const std::vector<double>& sos);
+
+public:
+    Q_INVOKABLE explicit QDaqIirFilter(const QString& name);
+
+    // getters
+    virtual int nInputChannels() const { return inputChannels().size(); }
+    virtual int nOutputChannels() const { return inputChannels().size(); }
+    FilterType type() const { return type_; }
+    FilterDesign design() const { return design_; }
+    int order() const { return order_; }
+    double frequency() const { return f1_; }
+    double frequency2() const { return f2_; }
+    double ripple() const { return ripple_; }
+    double samplingRate() const { return fs_; }
+    QDaqVector sos() const;
+    int sections() const { return params_.staged().sos.size()/6; }
+
+    // setters
+    void setType(FilterType t);
+    void setDesign(FilterDesign d);
+    void setOrder(int n);
+    void setFrequency(double f);
+    void setFrequency2(double f);
+    void setRipple(double r);
+    void setSamplingRate(double f);
+    void setSos(const QDaqVector& v);
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterblock(const double* vin, double* vout, int n);
+
+public slots:
+    /// Reset the filter state.
+    void clear();
+};
+
+#endif // QDAQIIRFILTER_H
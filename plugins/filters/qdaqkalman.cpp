@@ -0,0 +1,281 @@
+#include "qdaqkalman.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+
+QDaqKalman::QDaqKalman(const QString& name) :
+    QDaqFilter(name),
+    steady_(false),
+    n_(0), m_(0), p_(0), nout_(0),
+    step_(0)
+{
+    // default: a random walk measured by one sensor
+    F_ << 1.;
+    H_ << 1.;
+    Q_ << 1e-4;
+    R_ << 1e-2;
+}
+
+int QDaqKalman::states() const
+{
+    int n = (int)std::floor(std::sqrt((double)F_.size()) + 0.5);
+    return n*n==F_.size() ? n : 0;
+}
+
+QDaqVector QDaqKalman::state() const
+{
+    QMutexLocker L(&readLock_);
+    xOut_.update();
+    const std::vector<double>& x = xOut_.read();
+    QDaqVector v;
+    v.push(x.data(), (int)x.size());
+    return v;
+}
+
+void QDaqKalman::setMatrix(QDaqVector& M, const QDaqVector& v)
+{
+    if (throwIfArmed()) return;
+    M = v.clone();
+    emit propertiesChanged();
+}
+
+void QDaqKalman::setSteadyState(bool on)
+{
+    if (throwIfArmed()) return;
+    if (steady_ != on)
+    {
+        steady_ = on;
+        emit propertiesChanged();
+    }
+}
+
+// The kernels. N is the number of states, or 0 if it is given by n_
+
+// covariance prediction P = F P F' + Q
+template<int N>
+static inline void covPredict(int n_, const double* F, const double* Q, double* P, double* T)
+{
+    const int n = N ? N : n_;
+    for(int i=0; i<n; ++i)
+        for(int j=0; j<n; ++j)
+        {
+            double s = 0.;
+            for(int l=0; l<n; ++l) s += F[i*n+l]*P[l*n+j];
+            T[i*n+j] = s;
+        }
+    for(int i=0; i<n; ++i)
+        for(int j=0; j<n; ++j)
+        {
+            double s = Q[i*n+j];
+            for(int l=0; l<n; ++l) s += T[i*n+l]*F[j*n+l];
+            P[i*n+j] = s;
+        }
+}
+
+// covariance update with measurement row h and variance r.
+// Returns the gain in K
+template<int N>
+static inline void covUpdate(int n_, const double* h, double r, double* P, double* Ph, double* K)
+{
+    const int n = N ? N : n_;
+    double s = r;
+    for(int a=0; a<n; ++a)
+    {
+        double v = 0.;
+        for(int b=0; b<n; ++b) v += P[a*n+b]*h[b];
+        Ph[a] = v;
+        s += h[a]*v;
+    }
+    for(int a=0; a<n; ++a) K[a] = Ph[a]/s;
+    for(int a=0; a<n; ++a)
+        for(int b=0; b<n; ++b)
+            P[a*n+b] -= K[a]*Ph[b];
+}
+
+template<int N>
+void QDaqKalman::predict(const double* u)
+{
+    const int n = N ? N : n_;
+    const int p = p_;
+    const double* F = f_.data();
+    const double* B = b_.data();
+    double* x = x_.data();
+    double* t = ph_.data();
+
+    // x = F x + B u
+    for(int i=0; i<n; ++i)
+    {
+        double s = 0.;
+        for(int j=0; j<n; ++j) s += F[i*n+j]*x[j];
+        for(int l=0; l<p; ++l) s += B[i*p+l]*u[l];
+        t[i] = s;
+    }
+    for(int i=0; i<n; ++i) x[i] = t[i];
+
+    if (!steady_) covPredict<N>(n_, F, q_.data(), P_.data(), t_.data());
+}
+
+template<int N>
+void QDaqKalman::update(const double* z)
+{
+    const int n = N ? N : n_;
+    double* x = x_.data();
+    for(int i=0; i<m_; ++i)
+    {
+        // no measurement
+        if (!std::isfinite(z[i])) continue;
+
+        const double* h = &h_[i*n];
+        double y = z[i];
+        for(int a=0; a<n; ++a) y -= h[a]*x[a];
+
+        double* K = &k_[i*n];
+        if (!steady_) covUpdate<N>(n_, h, r_[i], P_.data(), ph_.data(), K);
+        for(int a=0; a<n; ++a) x[a] += K[a]*y;
+    }
+}
+
+template<int N>
+void QDaqKalman::step(const double* z, const double* u)
+{
+    predict<N>(u);
+    update<N>(z);
+}
+
+bool QDaqKalman::steadyGain()
+{
+    const int n = n_;
+    std::vector<double> Pold(n*n);
+    for(int it=0; it<100000; ++it)
+    {
+        Pold = P_;
+        covPredict<0>(n, f_.data(), q_.data(), P_.data(), t_.data());
+        for(int i=0; i<m_; ++i)
+            covUpdate<0>(n, &h_[i*n], r_[i], P_.data(), ph_.data(), &k_[i*n]);
+
+        double d = 0., pmax = 0.;
+        for(int i=0; i<n*n; ++i)
+        {
+            d = std::max(d, std::fabs(P_[i] - Pold[i]));
+            pmax = std::max(pmax, std::fabs(P_[i]));
+        }
+        if (d <= 1e-13*pmax) return true;
+    }
+    return false;
+}
+
+bool QDaqKalman::filterinit()
+{
+    const int n = states();
+    if (n < 1)
+    {
+        throwScriptError("F must be a square matrix.");
+        return false;
+    }
+    if (H_.size()==0 || H_.size() % n)
+    {
+        throwScriptError(QString("H must have %1 columns.").arg(n));
+        return false;
+    }
+    const int m = H_.size()/n;
+    if (Q_.size() != n*n)
+    {
+        throwScriptError(QString("Q must be a %1 x %1 matrix.").arg(n));
+        return false;
+    }
+    if (R_.size() != m)
+    {
+        throwScriptError(QString("R must have %1 elements.").arg(m));
+        return false;
+    }
+    for(int i=0; i<m; ++i)
+        if (!(R_[i] > 0.))
+        {
+            throwScriptError("Measurement variances must be > 0.");
+            return false;
+        }
+    if (B_.size() % n)
+    {
+        throwScriptError(QString("B must have %1 rows.").arg(n));
+        return false;
+    }
+    const int p = B_.size()/n;
+    if (inputChannels().size() != m + p)
+    {
+        throwScriptError(QString("%1 measurement and %2 control input channels are needed.").arg(m).arg(p));
+        return false;
+    }
+    if (x0_.size()!=0 && x0_.size()!=n)
+    {
+        throwScriptError(QString("x0 must have %1 elements.").arg(n));
+        return false;
+    }
+    if (P0_.size()!=0 && P0_.size()!=n*n)
+    {
+        throwScriptError(QString("P0 must be a %1 x %1 matrix.").arg(n));
+        return false;
+    }
+
+    n_ = n;
+    m_ = m;
+    p_ = p;
+    nout_ = nOutputChannels();
+
+    f_.assign(F_.constData(), F_.constData() + n*n);
+    h_.assign(H_.constData(), H_.constData() + m*n);
+    q_.assign(Q_.constData(), Q_.constData() + n*n);
+    r_.assign(R_.constData(), R_.constData() + m);
+    b_.assign(B_.constData(), B_.constData() + n*p);
+    if (x0_.size()) x_.assign(x0_.constData(), x0_.constData() + n);
+    else x_.assign(n, 0.);
+    if (P0_.size()) P_.assign(P0_.constData(), P0_.constData() + n*n);
+    else {
+        P_.assign(n*n, 0.);
+        for(int i=0; i<n; ++i) P_[i*n+i] = 1.;
+    }
+    t_.assign(n*n, 0.);
+    ph_.assign(n, 0.);
+    k_.assign(m*n, 0.);
+
+    // select the kernel
+    switch(n)
+    {
+    case 1: step_ = &QDaqKalman::step<1>; break;
+    case 2: step_ = &QDaqKalman::step<2>; break;
+    case 3: step_ = &QDaqKalman::step<3>; break;
+    case 4: step_ = &QDaqKalman::step<4>; break;
+    case 5: step_ = &QDaqKalman::step<5>; break;
+    case 6: step_ = &QDaqKalman::step<6>; break;
+    default: step_ = &QDaqKalman::step<0>; break;
+    }
+
+    if (steady_ && !steadyGain())
+    {
+        throwScriptError("The steady-state gain did not converge.");
+        return false;
+    }
+
+    {
+        QMutexLocker L(&readLock_);
+        xOut_.reset(x_);
+    }
+
+    return true;
+}
+
+bool QDaqKalman::filterfunc(const double* vin, double* vout)
+{
+    (this->*step_)(vin, vin + m_);
+
+    const int n = n_;
+    for(int i=0; i<n; ++i) vout[i] = x_[i];
+    if (nout_==2*n)
+        for(int i=0; i<n; ++i) vout[n+i] = std::sqrt(std::max(P_[i*n+i], 0.));
+
+    std::copy(x_.begin(), x_.end(), xOut_.back().begin());
+    xOut_.publish();
+
+    return true;
+}
@@ -0,0 +1,136 @@
+#ifndef QDAQKALMAN_H
+#define QDAQKALMAN_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "QDaqVector.h"
+#include "os_util.h"
+
+#include <QMutex>
+
+#include <vector>
+
+/**
+ * @brief Linear Kalman filter.
+ *
+ * Estimates the n-dimensional state x of the linear model
+ *
+ *   x[k] = F x[k-1] + B u[k] + w,   cov(w) = Q
+ *   z[k] = H x[k] + v,              cov(v) = diag(R)
+ *
+ * from m measurements z and p known inputs u.
+ *
+ * The input channels are the m measurements followed by the p control inputs.
+ * The output channels are the n state estimates and, if 2n output channels
+ * are given, also their standard deviations.
+ *
+ * Matrices are given as QDaqVector in row-major order: F (n x n), H (m x n),
+ * Q (n x n), B (n x p, may be empty), R holds the m measurement variances.
+ * The initial state x0 and covariance P0 are optional (default 0 and the
+ * identity).
+ *
+ * The measurements are assumed independent and are applied one at a time,
+ * thus no matrix inversion is needed. A measurement that is not finite
+ * (e.g. a sensor that has no new value) is skipped, which allows fusion of
+ * sensors with different rates.
+ *
+ * If steadyState is set, the Riccati equation is iterated at arm until the
+ * gain converges and only the state is propagated at run time. The
+ * steady-state gain assumes that all measurements are available at every
+ * step; the standard deviations are then those of the steady state.
+ *
+ * For n <= 6 the update runs in kernels with the dimension fixed at compile
+ * time, which are selected at arm.
+ *
+ * The model can be changed only when the filter is not armed.
+ */
+class FILTERSSHARED_EXPORT QDaqKalman :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// State transition matrix F (n x n).
+    Q_PROPERTY(QDaqVector F READ F WRITE setF)
+    /// Measurement matrix H (m x n).
+    Q_PROPERTY(QDaqVector H READ H WRITE setH)
+    /// Process noise covariance Q (n x n).
+    Q_PROPERTY(QDaqVector Q READ Q WRITE setQ)
+    /// Measurement noise variances (m).
+    Q_PROPERTY(QDaqVector R READ R WRITE setR)
+    /// Control input matrix B (n x p), may be empty.
+    Q_PROPERTY(QDaqVector B READ B WRITE setB)
+    /// Initial state (n), may be empty.
+    Q_PROPERTY(QDaqVector x0 READ x0 WRITE setX0)
+    /// Initial covariance (n x n), may be empty.
+    Q_PROPERTY(QDaqVector P0 READ P0 WRITE setP0)
+    /// Use the precomputed steady-state gain.
+    Q_PROPERTY(bool steadyState READ steadyState WRITE setSteadyState)
+    /// Number of states n (read-only).
+    Q_PROPERTY(int states READ states)
+    /// State estimate of the last sample (read-only).
+    Q_PROPERTY(QDaqVector state READ state)
+
+protected:
+    QDaqVector F_, H_, Q_, R_, B_, x0_, P0_;
+    bool steady_;
+
+    // dimensions set at arm
+    int n_, m_, p_, nout_;
+    // model, state and work space
+    std::vector<double> f_, h_, q_, r_, b_, x_, P_, t_, ph_, k_;
+
+    // one step of the filter: predict and update
+    typedef void (QDaqKalman::*step_t)(const double* z, const double* u);
+    step_t step_;
+    template<int N> void step(const double* z, const double* u);
+    template<int N> void predict(const double* u);
+    template<int N> void update(const double* z);
+
+    bool steadyGain();
+
+    // state published by the loop thread for state().
+    // The loop never waits; readLock_ only serializes the readers.
+    mutable os::triple_buffer< std::vector<double> > xOut_;
+    mutable QMutex readLock_;
+
+    void setMatrix(QDaqVector& M, const QDaqVector& v);
+
+public:
+    Q_INVOKABLE explicit QDaqKalman(const QString& name);
+
+    // getters
+    virtual int nInputChannels() const { return inputChannels().size(); }
+    // n states and optionally their std
+    virtual int nOutputChannels() const
+    {
+        int n = states();
+        return outputChannels().size()==2*n ? 2*n : n;
+    }
+    QDaqVector F() const { return F_; }
+    QDaqVector H() const { return H_; }
+    QDaqVector Q() const { return Q_; }
+    QDaqVector R() const { return R_; }
+    QDaqVector B() const { return B_; }
+    QDaqVector x0() const { return x0_; }
+    QDaqVector P0() const { return P0_; }
+    bool steadyState() const { return steady_; }
+    int states() const;
+    QDaqVector state() const;
+
+    // setters
+    void setF(const QDaqVector& v) { setMatrix(F_, v); }
+    void setH(const QDaqVector& v) { setMatrix(H_, v); }
+    void setQ(const QDaqVector& v) { setMatrix(Q_, v); }
+    void setR(const QDaqVector& v) { setMatrix(R_, v); }
+    void setB(const QDaqVector& v) { setMatrix(B_, v); }
+    void setX0(const QDaqVector& v) { setMatrix(x0_, v); }
+    void setP0(const QDaqVector& v) { setMatrix(P0_, v); }
+    void setSteadyState(bool on);
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterfunc(const double* vin, double* vout);
+};
+
+#endif // QDAQKALMAN_H
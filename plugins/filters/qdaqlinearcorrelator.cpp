@@ -1,10 +1,14 @@
 #include "qdaqlinearcorrelator.h"
-#include "linefit.h"
+
+#include <cmath>
 
 QDaqLinearCorrelator::QDaqLinearCorrelator(const QString& name) :
     QDaqFilter(name),
     size_(2),
-    len_(0)
+    len_(0),
+    mx_(0.), my_(0.), sxx_(0.), syy_(0.), sxy_(0.),
+    updates_(0),
+    nout_(2)
 {
     x_.alloc(2);
     y_.alloc(2);
@@ -15,11 +19,12 @@ void QDaqLinearCorrelator::setSize(uint sz)
     if ((sz!=size()) && sz>1)
     {
         {
-            QMutexLocker L(&comm_lock);
+            JobLocker L(this);
             x_.alloc(sz);
             y_.alloc(sz);
             size_ = sz;
             len_ = 0;
+            recompute();
         }
         emit propertiesChanged();
     }
@@ -27,27 +32,96 @@ void QDaqLinearCorrelator::setSize(uint sz)
 
 bool QDaqLinearCorrelator::filterinit()
 {
+    nout_ = nOutputChannels();
     len_ = 0;
+    recompute();
     return true;
 }
 
+// add (x,y) to the window, len_ already includes the new point
+void QDaqLinearCorrelator::addPoint(double x, double y)
+{
+    double dx = x - mx_;
+    double dy = y - my_;
+    mx_ += dx/len_;
+    my_ += dy/len_;
+    sxx_ += dx*(x - mx_);
+    syy_ += dy*(y - my_);
+    sxy_ += dx*(y - my_);
+}
+
+// remove (x,y) from the window, len_ already excludes the point
+void QDaqLinearCorrelator::removePoint(double x, double y)
+{
+    if (len_==0) { recompute(); return; }
+    double dx = x - mx_;
+    double dy = y - my_;
+    mx_ -= dx/len_;
+    my_ -= dy/len_;
+    sxx_ -= dx*(x - mx_);
+    syy_ -= dy*(y - my_);
+    sxy_ -= dx*(y - my_);
+}
+
+// exact two-pass computation from the buffered points
+void QDaqLinearCorrelator::recompute()
+{
+    mx_ = my_ = sxx_ = syy_ = sxy_ = 0.;
+    updates_ = 0;
+    if (len_==0) return;
+    for(uint i=0; i<len_; ++i) {
+        mx_ += x_[i];
+        my_ += y_[i];
+    }
+    mx_ /= len_;
+    my_ /= len_;
+    for(uint i=0; i<len_; ++i) {
+        double dx = x_[i] - mx_;
+        double dy = y_[i] - my_;
+        sxx_ += dx*dx;
+        syy_ += dy*dy;
+        sxy_ += dx*dy;
+    }
+}
+
 bool QDaqLinearCorrelator::filterfunc(const double* vin, double* vout)
 {
+    // drop the oldest point if the window is full
+    if (len_ == size_) {
+        len_--;
+        removePoint(x_[len_], y_[len_]);
+    }
     x_ << vin[0];
     y_ << vin[1];
-    if (len_ < size_) len_++;
-    if (len_>1)
+    len_++;
+    addPoint(vin[0], vin[1]);
+
+    if (++updates_ >= size_) recompute();
+
+    double a = 0., b = 0., r2 = 0., sres = 0.;
+    if (len_>1 && sxx_ > 0.)
     {
-        linefit<double> fitobj(x_,y_,len_);
-        vout[0] = fitobj.a;
-        vout[1] = fitobj.b;
-    } else vout[0] = vout[1] = 0.;
+        b = sxy_/sxx_;
+        a = my_ - b*mx_;
+        // residual sum of squares
+        double ssres = syy_ - b*sxy_;
+        if (ssres < 0.) ssres = 0.;
+        r2 = syy_ > 0. ? 1. - ssres/syy_ : 1.;
+        if (len_>2) sres = std::sqrt(ssres/(len_-2));
+    }
+    vout[0] = a;
+    vout[1] = b;
+    if (nout_==4) {
+        vout[2] = r2;
+        vout[3] = sres;
+    }
 
     return true;
 }
 
 void QDaqLinearCorrelator::clear()
 {
-    QMutexLocker L(&comm_lock);
+    JobLocker L(this);
     len_ = 0;
+    recompute();
 }
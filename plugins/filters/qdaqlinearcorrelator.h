@@ -6,6 +6,18 @@
 #include "QDaqFilter.h"
 #include "QDaqTypes.h"
 
+/**
+ * @brief Linear regression y = a + b*x over a sliding window of (x,y) points.
+ *
+ * Inputs are x and y. The outputs are the intercept a and the slope b and,
+ * if 4 output channels are given, also the coefficient of determination r^2
+ * and the standard deviation of the residuals.
+ *
+ * The window sums are updated incrementally (centered, Welford-type update)
+ * when a point enters or leaves the window, so the cost per sample does not
+ * depend on the window size. They are recomputed from the buffered data
+ * once per window length to remove accumulated rounding errors.
+ */
 class FILTERSSHARED_EXPORT QDaqLinearCorrelator :
         public QDaqFilter
 {
@@ -24,6 +36,17 @@ class FILTERSSHARED_EXPORT QDaqLinearCorrelator :
 
     uint size_, len_;
 
+    // means and centered sums of the points in the window
+    double mx_, my_, sxx_, syy_, sxy_;
+    // samples since the last exact recomputation
+    uint updates_;
+    // number of outputs, set at arm
+    int nout_;
+
+    void addPoint(double x, double y);
+    void removePoint(double x, double y);
+    void recompute();
+
 public:
     Q_INVOKABLE explicit QDaqLinearCorrelator(const QString& name);
 
@@ -31,7 +54,8 @@ public:
     uint size() const { return size_; }
     uint length() const { return len_; }
     virtual int nInputChannels() const { return 2; }
-    virtual int nOutputChannels() const { return 2; }
+    // a, b and optionally r^2, residual std
+    virtual int nOutputChannels() const { return outputChannels().size()==4 ? 4 : 2; }
 
     // setters
     void setSize(uint sz);
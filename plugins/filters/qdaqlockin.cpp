@@ -0,0 +1,315 @@
+#include "qdaqlockin.h"
+
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+QDaqLockIn::QDaqLockIn(const QString& name) :
+    QDaqFilter(name),
+    reference_(Internal),
+    fs_(0.),
+    rate_(0.),
+    nout_(2),
+    clearSeq_(0),
+    phase_(0.), dph_(0.),
+    zc_(1.), zs_(0.), rc_(1.), rs_(0.),
+    reseed_(true),
+    r0_(0.), since_(0.), refDph_(0.),
+    crossed_(false),
+    a_(1.)
+{
+    os::published<params_t>::editor p(params_);
+    p->f = 10.;
+    p->phase = 0.;
+    p->tau = 0.1;
+    p->harmonic = 1;
+    p->order = 2;
+    p->clearSeq = clearSeq_;
+
+    for(int i=0; i<MaxOrder; ++i) lpx_[i] = lpy_[i] = 0.;
+}
+
+void QDaqLockIn::adoptParams()
+{
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+
+    dph_ = p.f/rate_;
+    a_ = p.tau > 0. ? 1. - std::exp(-1./(rate_*p.tau)) : 1.;
+    reseed_ = true;
+
+    if (p.clearSeq != clearSeq_)
+    {
+        clearSeq_ = p.clearSeq;
+        for(int i=0; i<MaxOrder; ++i) lpx_[i] = lpy_[i] = 0.;
+    }
+}
+
+// Set the phasor to the reference phase ph (cycles) and
+// compute the rotations per sample
+void QDaqLockIn::reseed(double ph)
+{
+    const params_t& p = params_.current();
+    const double h = p.harmonic, off = p.phase/360.;
+    double w = 2*M_PI*(h*ph + off);
+    zc_ = std::cos(w);
+    zs_ = std::sin(w);
+    if (reference_==Internal)
+    {
+        for(size_t j=0; j<tc_.size(); ++j)
+        {
+            // j*dph_ may be large, reduce to [0,1) cycles first
+            double c = j*dph_;
+            c -= std::floor(c);
+            tc_[j] = std::cos(2*M_PI*h*c);
+            ts_[j] = std::sin(2*M_PI*h*c);
+        }
+    }
+    else
+    {
+        rc_ = std::cos(2*M_PI*h*refDph_);
+        rs_ = std::sin(2*M_PI*h*refDph_);
+    }
+    reseed_ = false;
+}
+
+bool QDaqLockIn::filterinit()
+{
+    rate_ = fs_ > 0. ? fs_ : (top_ && top_->period() ? 1000.*blockSize_/top_->period() : 0.);
+    if (rate_ <= 0.)
+    {
+        throwScriptError("Unknown sampling rate.");
+        return false;
+    }
+    nout_ = nOutputChannels();
+
+    uint n = blockSize_ > 1 ? blockSize_ : 1;
+    tc_.assign(n + 1, 1.);
+    ts_.assign(n + 1, 0.);
+
+    // force re-calculation of the coefficients
+    {
+        os::published<params_t>::editor p(params_);
+    }
+    adoptParams();
+    clearSeq_ = params_.current().clearSeq;
+
+    phase_ = 0.;
+    r0_ = 0.;
+    since_ = 0.;
+    refDph_ = 0.;
+    crossed_ = false;
+    for(int i=0; i<MaxOrder; ++i) lpx_[i] = lpy_[i] = 0.;
+
+    reseed_ = true;
+    c_.assign(n, 0.);
+    s_.assign(n, 0.);
+    x_.assign(n, 0.);
+    y_.assign(n, 0.);
+    return true;
+}
+
+bool QDaqLockIn::filterblock(const double* vin, double* vout, int n)
+{
+    adoptParams();
+    const params_t& p = params_.current();
+
+    // oscillator
+    double* c = c_.data();
+    double* s = s_.data();
+    if (reference_==Internal)
+    {
+        if (reseed_) reseed(phase_);
+        const double zc = zc_, zs = zs_;
+        const double* tc = tc_.data();
+        const double* ts = ts_.data();
+        for(int j=0; j<n; ++j)
+        {
+            c[j] = zc*tc[j] - zs*ts[j];
+            s[j] = zs*tc[j] + zc*ts[j];
+        }
+        // advance by n samples
+        zc_ = zc*tc[n] - zs*ts[n];
+        zs_ = zs*tc[n] + zc*ts[n];
+        phase_ += n*dph_;
+        phase_ -= std::floor(phase_);
+    }
+    else
+    {
+        if (reseed_) reseed(since_*refDph_);
+        const double* r = vin + n;
+        for(int j=0; j<n; ++j)
+        {
+            double r1 = r[j];
+            since_ += 1.;
+            if (r0_ < 0. && r1 >= 0.)
+            {
+                // rising zero crossing, interpolated between the samples
+                double dt = r1/(r1 - r0_);
+                if (crossed_) refDph_ = 1./(since_ - dt);
+                crossed_ = true;
+                since_ = dt;
+                reseed(since_*refDph_);
+            }
+            else
+            {
+                double zc = zc_*rc_ - zs_*rs_;
+                zs_ = zs_*rc_ + zc_*rs_;
+                zc_ = zc;
+            }
+            r0_ = r1;
+            c[j] = zc_;
+            s[j] = zs_;
+        }
+    }
+    // renormalize the phasor (one Newton step for 1/|z|)
+    {
+        double g = 1.5 - 0.5*(zc_*zc_ + zs_*zs_);
+        zc_ *= g;
+        zs_ *= g;
+    }
+
+    // mixer
+    double* x = x_.data();
+    double* y = y_.data();
+    for(int j=0; j<n; ++j)
+    {
+        x[j] = 2*vin[j]*s[j];
+        y[j] = 2*vin[j]*c[j];
+    }
+
+    // low-pass stages
+    const double a = a_;
+    for(int k=0; k<p.order; ++k)
+    {
+        double u = lpx_[k], v = lpy_[k];
+        for(int j=0; j<n; ++j)
+        {
+            u += a*(x[j] - u);
+            v += a*(y[j] - v);
+            x[j] = u;
+            y[j] = v;
+        }
+        lpx_[k] = u;
+        lpy_[k] = v;
+    }
+
+    for(int j=0; j<n; ++j)
+    {
+        vout[j] = x[j];
+        vout[n+j] = y[j];
+    }
+    if (nout_==4)
+    {
+        for(int j=0; j<n; ++j)
+        {
+            vout[2*n+j] = std::sqrt(x[j]*x[j] + y[j]*y[j]);
+            vout[3*n+j] = std::atan2(y[j], x[j])*180./M_PI;
+        }
+    }
+
+    return true;
+}
+
+// setters
+void QDaqLockIn::setReference(ReferenceType r)
+{
+    if (throwIfArmed()) return;
+    if ((int)r==-1)
+    {
+        throwScriptError("Invalid reference specification. Availiable options: "
+                         "Internal, External");
+        return;
+    }
+    if (reference_ != r)
+    {
+        reference_ = r;
+        emit propertiesChanged();
+    }
+}
+void QDaqLockIn::setFrequency(double f)
+{
+    if (f < 0.)
+    {
+        throwScriptError("Frequency must be >= 0.");
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        p->f = f;
+    }
+    emit propertiesChanged();
+}
+void QDaqLockIn::setPhase(double v)
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->phase = v;
+    }
+    emit propertiesChanged();
+}
+void QDaqLockIn::setHarmonic(int h)
+{
+    if (h < 1)
+    {
+        throwScriptError("Harmonic must be >= 1.");
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        p->harmonic = h;
+    }
+    emit propertiesChanged();
+}
+void QDaqLockIn::setTimeConstant(double v)
+{
+    if (v < 0.)
+    {
+        throwScriptError("Time constant must be >= 0.");
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        p->tau = v;
+    }
+    emit propertiesChanged();
+}
+void QDaqLockIn::setFilterOrder(int n)
+{
+    if (n < 1 || n > MaxOrder)
+    {
+        throwScriptError(QString("Filter order must be between 1 and %1.").arg(int(MaxOrder)));
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        p->order = n;
+    }
+    emit propertiesChanged();
+}
+void QDaqLockIn::setSamplingRate(double f)
+{
+    if (throwIfArmed()) return;
+    if (f < 0.)
+    {
+        throwScriptError("Sampling rate must be >= 0.");
+        return;
+    }
+    if (fs_ != f)
+    {
+        fs_ = f;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLockIn::clear()
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->clearSeq++;
+    }
+    if (!armed())
+        for(int i=0; i<MaxOrder; ++i) lpx_[i] = lpy_[i] = 0.;
+}
@@ -0,0 +1,145 @@
+#ifndef QDAQLOCKIN_H
+#define QDAQLOCKIN_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "os_util.h"
+
+#include <vector>
+
+/**
+ * @brief Digital lock-in amplifier.
+ *
+ * The input signal x is multiplied by the reference oscillator
+ * sin(2 pi h f t + phase), cos(...) and the products are low-pass
+ * filtered by filterOrder cascaded first order stages of time constant
+ * timeConstant. For x = A sin(2 pi h f t + theta + phase) the outputs are
+ *
+ *   X = A cos(theta), Y = A sin(theta), R = A, theta (deg)
+ *
+ * Output channels are X, Y and, if 4 output channels are given, also R, theta.
+ *
+ * With reference = Internal the oscillator runs at frequency. With
+ * reference = External a second input channel carries the reference signal;
+ * its frequency and phase are measured at each rising zero crossing
+ * (interpolated between samples) and the oscillator follows them, i.e., a
+ * signal in phase with the reference has theta = 0. h is the harmonic property.
+ *
+ * The reference oscillator is a numerically controlled oscillator: a
+ * unit phasor is rotated by a complex multiplication at each sample and
+ * renormalized to |z| = 1 once per block, so no sin/cos is evaluated per
+ * sample. With the Internal reference the rotations e^(i 2 pi h f j/fs)
+ * for the samples j of a block are tabulated when the parameters change.
+ * The oscillator and the mixer are then independent loops over the block,
+ * which the compiler can vectorize. With the External reference the
+ * phasor is rotated sample by sample and re-synchronized at each zero
+ * crossing.
+ *
+ * The sampling rate is taken from the top loop (1000*blockSize/period)
+ * unless the samplingRate property is set.
+ */
+class FILTERSSHARED_EXPORT QDaqLockIn :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// Reference source: Internal oscillator or External reference channel.
+    Q_PROPERTY(ReferenceType reference READ reference WRITE setReference)
+    /// Frequency of the internal oscillator in Hz.
+    Q_PROPERTY(double frequency READ frequency WRITE setFrequency)
+    /// Phase shift of the reference in degrees.
+    Q_PROPERTY(double phase READ phase WRITE setPhase)
+    /// Detection harmonic of the reference frequency.
+    Q_PROPERTY(int harmonic READ harmonic WRITE setHarmonic)
+    /// Time constant of the low-pass stages in s.
+    Q_PROPERTY(double timeConstant READ timeConstant WRITE setTimeConstant)
+    /// Number of low-pass stages (1 ... 8), 6 dB/octave each.
+    Q_PROPERTY(int filterOrder READ filterOrder WRITE setFilterOrder)
+    /// Sampling rate in Hz. If 0 the sampling rate of the loop is used.
+    Q_PROPERTY(double samplingRate READ samplingRate WRITE setSamplingRate)
+    /// Measured frequency of the external reference in Hz, 0 if not locked (read-only).
+    Q_PROPERTY(double referenceFrequency READ referenceFrequency)
+
+public:
+    enum ReferenceType {
+        Internal,
+        External
+    };
+    Q_ENUM(ReferenceType)
+
+    enum { MaxOrder = 8 };
+
+protected:
+    ReferenceType reference_;
+    double fs_;
+    // sampling rate in use, set at arm
+    double rate_;
+    int nout_;
+
+    // on-line parameters, adopted in filterblock().
+    // clear() is a command applied when clearSeq changes.
+    struct params_t {
+        double f, phase, tau;
+        int harmonic, order;
+        uint clearSeq;
+    };
+    os::published<params_t> params_;
+    uint clearSeq_;
+    void adoptParams();
+
+    // internal oscillator phase and increment in cycles
+    double phase_, dph_;
+    // oscillator phasor and its rotation per sample (External)
+    double zc_, zs_, rc_, rs_;
+    // the phasor must be set from the phase (parameters changed)
+    bool reseed_;
+    // rotations of sample j of a block (Internal), j = 0 ... blockSize
+    std::vector<double> tc_, ts_;
+    void reseed(double ph);
+    // external reference: last sample, samples since the last
+    // zero crossing, frequency in cycles/sample
+    double r0_, since_, refDph_;
+    bool crossed_;
+    // low-pass coefficient and stage states
+    double a_;
+    double lpx_[MaxOrder], lpy_[MaxOrder];
+
+    // work buffers of one block
+    std::vector<double> c_, s_, x_, y_;
+
+public:
+    Q_INVOKABLE explicit QDaqLockIn(const QString& name);
+
+    // getters
+    virtual int nInputChannels() const { return reference_==External ? 2 : 1; }
+    // X, Y and optionally R, theta
+    virtual int nOutputChannels() const { return outputChannels().size()==4 ? 4 : 2; }
+    ReferenceType reference() const { return reference_; }
+    double frequency() const { return params_.staged().f; }
+    double phase() const { return params_.staged().phase; }
+    int harmonic() const { return params_.staged().harmonic; }
+    double timeConstant() const { return params_.staged().tau; }
+    int filterOrder() const { return params_.staged().order; }
+    double samplingRate() const { return fs_; }
+    double referenceFrequency() const { return refDph_*rate_; }
+
+    // setters
+    void setReference(ReferenceType r);
+    void setFrequency(double f);
+    void setPhase(double v);
+    void setHarmonic(int h);
+    void setTimeConstant(double v);
+    void setFilterOrder(int n);
+    void setSamplingRate(double f);
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterblock(const double* vin, double* vout, int n);
+
+public slots:
+    /// Reset the low-pass filters.
+    void clear();
+};
+
+#endif // QDAQLOCKIN_H
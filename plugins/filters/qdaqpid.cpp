@@ -6,12 +6,72 @@ QDaqPid::QDaqPid(const QString& name) :
     auto_(false),
     autotune_(false),
     Ts_(0),
-    W_(0)
+    W_(0),
+    tuneSeq_(0),
+    powerSeq_(0)
+{
+    os::published<params_t>::editor p(params_);
+    p->h = pid.get_h();
+    p->k = pid.get_k();
+    p->ti = pid.get_ti();
+    p->td = pid.get_td();
+    p->tr = pid.get_tr();
+    p->b = pid.get_b();
+    p->umax = pid.get_umax();
+    p->N = pid.get_N();
+    p->step = tuner.get_step();
+    p->dy = tuner.get_dy();
+    p->count = tuner.get_count();
+    p->setPoint = Ts_;
+    p->autoMode = auto_;
+    p->autoTune = autotune_;
+    p->power = W_;
+    p->tuneSeq = tuneSeq_;
+    p->powerSeq = powerSeq_;
+}
+
+void QDaqPid::adoptParams()
 {
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+
+    // each pid setter re-calculates the coefficients
+    if (p.h != pid.get_h()) pid.set_h(p.h);
+    if (p.k != pid.get_k()) pid.set_k(p.k);
+    if (p.ti != pid.get_ti()) pid.set_ti(p.ti);
+    if (p.td != pid.get_td()) pid.set_td(p.td);
+    if (p.tr != pid.get_tr()) pid.set_tr(p.tr);
+    if (p.b != pid.get_b()) pid.set_b(p.b);
+    if (p.N != pid.get_N()) pid.set_N(p.N);
+    pid.set_umax(p.umax);
+
+    tuner.set_step(p.step);
+    tuner.set_dy(p.dy);
+    tuner.set_count(p.count);
+
+    Ts_ = p.setPoint;
+    auto_ = p.autoMode;
+
+    if (p.tuneSeq != tuneSeq_)
+    {
+        tuneSeq_ = p.tuneSeq;
+        autotune_ = p.autoTune;
+    }
+    if (p.powerSeq != powerSeq_)
+    {
+        powerSeq_ = p.powerSeq;
+        if (!auto_) W_ = p.power;
+    }
 }
 
 bool QDaqPid::filterinit()
 {
+    {
+        os::published<params_t>::editor p(params_);
+        p->autoMode = false;
+        p->autoTune = false;
+    }
+    adoptParams();
     auto_ = false;
     autotune_ = false;
     W_ = 0;
@@ -20,13 +80,15 @@ bool QDaqPid::filterinit()
 
 bool QDaqPid::filterfunc(const double* vin, double *vout)
 {
+    adoptParams();
+
     double T = *vin;
 
     // go through autotuner
     //bool disableCtrl;
     bool ret = tuner(Ts_, T, W_, autotune_);
 
-    if (ret) emit propertiesChanged();
+    if (ret) notify(NotifyProperties);
 
     // go through pid
     pid(Ts_, T, W_, auto_ && !autotune_);
@@ -40,83 +102,113 @@ bool QDaqPid::filterfunc(const double* vin, double *vout)
 // setters
 void QDaqPid::setAutoMode(bool on)
 {
-    QMutexLocker L(&comm_lock);
-    auto_ = on;
+    {
+        os::published<params_t>::editor p(params_);
+        p->autoMode = on;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setAutoTune(bool on)
 {
-    QMutexLocker L(&comm_lock);
-    autotune_ = on;
+    {
+        os::published<params_t>::editor p(params_);
+        p->autoTune = on;
+        p->tuneSeq++;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setMaxPower(double v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_umax(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->umax = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setPower(double v)
 {
-    if (!auto_)
+    if (!autoMode())
     {
-        QMutexLocker L(&comm_lock);
-        W_ = v;
+        {
+            os::published<params_t>::editor p(params_);
+            p->power = v;
+            p->powerSeq++;
+        }
+        // apply immediately if not running
+        if (!armed()) { adoptParams(); }
         emit propertiesChanged();
     }
 }
 void QDaqPid::setSamplingPeriod(double v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_h(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->h = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setSetPoint(double v)
 {
-    QMutexLocker L(&comm_lock);
-    Ts_ = v;
+    {
+        os::published<params_t>::editor p(params_);
+        p->setPoint = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setGain(double v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_k(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->k = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setTi(double v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_ti(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->ti = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setTd(double v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_td(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->td = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setTr(double v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_tr(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->tr = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setNd(uint v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_N(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->N = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setBeta(double v)
 {
-    QMutexLocker L(&comm_lock);
-    pid.set_b(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->b = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setRelayStep(double v)
 {
-    QMutexLocker L(&comm_lock);
-    tuner.set_step(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->step = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setRelayOffset(double v)
@@ -125,13 +217,17 @@ void QDaqPid::setRelayOffset(double v)
 }
 void QDaqPid::setRelayThreshold(double v)
 {
-    QMutexLocker L(&comm_lock);
-    tuner.set_dy(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->dy = v;
+    }
     emit propertiesChanged();
 }
 void QDaqPid::setRelayIterations(int v)
 {
-    QMutexLocker L(&comm_lock);
-    tuner.set_count(v);
+    {
+        os::published<params_t>::editor p(params_);
+        p->count = v;
+    }
     emit propertiesChanged();
 }
@@ -4,6 +4,7 @@
 #include "filters_global.h"
 
 #include "QDaqFilter.h"
+#include "os_util.h"
 #include <QtPlugin>
 
 #include "isa_pid.h"
@@ -40,6 +41,23 @@ protected:
     isa_pid<double> pid;
     autotuner<double> tuner;
 
+    // Parameters set by the user, adopted in filterfunc().
+    // autoTune and power are commands: they are applied
+    // only when their sequence number changes.
+    struct params_t {
+        double h, k, ti, td, tr, b, umax;
+        int N;
+        double step, dy;
+        int count;
+        double setPoint;
+        bool autoMode, autoTune;
+        double power;
+        uint tuneSeq, powerSeq;
+    };
+    os::published<params_t> params_;
+    uint tuneSeq_, powerSeq_;
+    void adoptParams();
+
 public:
     Q_INVOKABLE explicit QDaqPid(const QString& name);
 
@@ -47,21 +65,21 @@ public:
     // getters
     virtual int nInputChannels() const { return 1; }
     virtual int nOutputChannels() const { return 1; }
-    bool autoMode() const { return auto_; }
-    double maxPower() const { return pid.get_umax(); }
+    bool autoMode() const { return params_.staged().autoMode; }
+    double maxPower() const { return params_.staged().umax; }
     double power() const { return W_; }
-    double samplingPeriod() const { return pid.get_h(); }
-    double setPoint() const { return Ts_; }
-    double gain() const { return pid.get_k(); }
-    double Ti() const { return pid.get_ti(); }
-    double Td() const { return pid.get_td(); }
-    double Tr() const { return pid.get_tr(); }
-    uint Nd() const { return pid.get_N(); }
-    double beta() const { return pid.get_b(); }
-    double relayStep() const { return tuner.get_step(); }
+    double samplingPeriod() const { return params_.staged().h; }
+    double setPoint() const { return params_.staged().setPoint; }
+    double gain() const { return params_.staged().k; }
+    double Ti() const { return params_.staged().ti; }
+    double Td() const { return params_.staged().td; }
+    double Tr() const { return params_.staged().tr; }
+    uint Nd() const { return params_.staged().N; }
+    double beta() const { return params_.staged().b; }
+    double relayStep() const { return params_.staged().step; }
     double relayOffset() const { return 0; }
-    double relayThreshold() const { return tuner.get_dy(); }
-    int relayIterations() const { return tuner.get_count(); }
+    double relayThreshold() const { return params_.staged().dy; }
+    int relayIterations() const { return params_.staged().count; }
     double Kc() const { return tuner.get_kc(); }
     double Tc() const { return tuner.get_tc()*pid.get_h(); }
     bool autoTune() const { return autotune_; }
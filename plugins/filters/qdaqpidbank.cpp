@@ -0,0 +1,244 @@
+#include "qdaqpidbank.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+QDaqPidBank::QDaqPidBank(const QString& name) :
+    QDaqFilter(name),
+    powerSeq_(0),
+    zones_(0),
+    auto_(false),
+    atp_(false)
+{
+    // same defaults as isa_pid
+    os::published<params_t>::editor p(params_);
+    p->h = 1.;
+    p->N = 5;
+    p->autoMode = false;
+    p->sp.assign(1, 0.);
+    p->k.assign(1, 1.);
+    p->ti.assign(1, 0.);
+    p->td.assign(1, 0.);
+    p->tr.assign(1, 0.);
+    p->b.assign(1, 1.);
+    p->umax.assign(1, 1.);
+    p->power.assign(1, 0.);
+    p->powerSeq = powerSeq_;
+}
+
+void QDaqPidBank::expand(const std::vector<double>& src, std::vector<double>& dst) const
+{
+    if (src.size()==1) std::fill(dst.begin(), dst.end(), src[0]);
+    else std::copy(src.begin(), src.begin() + zones_, dst.begin());
+}
+
+void QDaqPidBank::adoptParams()
+{
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+    const int n = zones_;
+
+    // the arrays have zones_ elements (allocated in filterinit)
+    expand(p.sp, sp_);
+    expand(p.k, k_);
+    expand(p.b, b_);
+    expand(p.umax, umax_);
+
+    // coefficients as in isa_pid::update_par()
+    const double h = p.h;
+    const double N = p.N;
+    for(int i=0; i<n; ++i)
+    {
+        double ti = p.ti.size()==1 ? p.ti[0] : p.ti[i];
+        double td = p.td.size()==1 ? p.td[0] : p.td[i];
+        double tr = p.tr.size()==1 ? p.tr[0] : p.tr[i];
+        a1_[i] = ti != 0. ? k_[i]*h/ti : 0.;
+        a2_[i] = tr != 0. ? h/tr : 0.;
+        b1_[i] = td/(td + N*h);
+        b2_[i] = k_[i]*N*b1_[i];
+    }
+
+    auto_ = p.autoMode;
+
+    if (p.powerSeq != powerSeq_)
+    {
+        powerSeq_ = p.powerSeq;
+        if (!auto_) expand(p.power, cv_);
+    }
+}
+
+bool QDaqPidBank::filterinit()
+{
+    zones_ = inputChannels().size();
+    if (zones_==0)
+    {
+        throwScriptError("No input channels.");
+        return false;
+    }
+
+    {
+        os::published<params_t>::editor p(params_);
+        const std::vector<double>* v[] = { &p->sp, &p->k, &p->ti, &p->td, &p->tr,
+                                           &p->b, &p->umax, &p->power };
+        for(unsigned int i=0; i<sizeof(v)/sizeof(v[0]); ++i)
+        {
+            int m = v[i]->size();
+            if (m!=1 && m!=zones_)
+            {
+                throwScriptError(QString("Parameter vectors must have 1 or %1 elements.").arg(zones_));
+                return false;
+            }
+        }
+        p->autoMode = false;
+    }
+
+    sp_.assign(zones_, 0.);
+    k_.assign(zones_, 0.);
+    b_.assign(zones_, 0.);
+    umax_.assign(zones_, 0.);
+    a1_.assign(zones_, 0.);
+    a2_.assign(zones_, 0.);
+    b1_.assign(zones_, 0.);
+    b2_.assign(zones_, 0.);
+    ui_.assign(zones_, 0.);
+    ud_.assign(zones_, 0.);
+    pvp_.assign(zones_, 0.);
+    cv_.assign(zones_, 0.);
+
+    adoptParams();
+    auto_ = false;
+    atp_ = false;
+    std::fill(cv_.begin(), cv_.end(), 0.);
+    {
+        QMutexLocker L(&readLock_);
+        cvOut_.reset(cv_);
+    }
+    return true;
+}
+
+bool QDaqPidBank::filterfunc(const double* vin, double* vout)
+{
+    adoptParams();
+
+    const int n = zones_;
+    const bool am = auto_;
+    // auto switched on: reset the integral and derivative terms
+    const double keep = (am && !atp_) ? 0. : 1.;
+
+    const double* sp = sp_.data();
+    const double* k = k_.data();
+    const double* b = b_.data();
+    const double* umax = umax_.data();
+    const double* a1 = a1_.data();
+    const double* a2 = a2_.data();
+    const double* b1 = b1_.data();
+    const double* b2 = b2_.data();
+    double* ui = ui_.data();
+    double* ud = ud_.data();
+    double* pvp = pvp_.data();
+    double* cv = cv_.data();
+
+    for(int i=0; i<n; ++i)
+    {
+        double pv = vin[i];
+        double up = k[i]*(b[i]*sp[i] - pv);
+        double d = keep*(b1[i]*ud[i] - b2[i]*(pv - pvp[i]));
+        double in = keep*ui[i];
+        double v = up + in + d;
+        double u = std::min(std::max(v, 0.), umax[i]);
+        double c = am ? u : cv[i];
+        ui[i] = in + a1[i]*(sp[i] - pv) + a2[i]*(c - v);
+        ud[i] = d;
+        pvp[i] = pv;
+        cv[i] = c;
+        vout[i] = c;
+    }
+    atp_ = am;
+
+    std::copy(cv, cv + n, cvOut_.back().begin());
+    cvOut_.publish();
+
+    return true;
+}
+
+QDaqVector QDaqPidBank::getParam(param_ptr m) const
+{
+    const std::vector<double>& c = params_.staged().*m;
+    QDaqVector v;
+    v.push(c.data(), (int)c.size());
+    return v;
+}
+
+void QDaqPidBank::setParam(param_ptr m, const QDaqVector& v)
+{
+    int n = v.size();
+    if (n==0 || (armed() && n!=1 && n!=zones_))
+    {
+        throwScriptError(QString("Parameter vectors must have 1 or %1 elements.").arg(zones()));
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        ((*p).*m).assign(v.constData(), v.constData() + n);
+    }
+    emit propertiesChanged();
+}
+
+QDaqVector QDaqPidBank::power() const
+{
+    if (!armed()) return getParam(&params_t::power);
+    QMutexLocker L(&readLock_);
+    cvOut_.update();
+    const std::vector<double>& c = cvOut_.read();
+    QDaqVector v;
+    v.push(c.data(), (int)c.size());
+    return v;
+}
+
+// setters
+void QDaqPidBank::setSamplingPeriod(double v)
+{
+    if (v <= 0.)
+    {
+        throwScriptError("Sampling period must be > 0.");
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        p->h = v;
+    }
+    emit propertiesChanged();
+}
+void QDaqPidBank::setNd(uint v)
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->N = v;
+    }
+    emit propertiesChanged();
+}
+void QDaqPidBank::setAutoMode(bool on)
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->autoMode = on;
+    }
+    emit propertiesChanged();
+}
+void QDaqPidBank::setPower(const QDaqVector& v)
+{
+    if (autoMode()) return;
+    int n = v.size();
+    if (n==0 || (armed() && n!=1 && n!=zones_))
+    {
+        throwScriptError(QString("Parameter vectors must have 1 or %1 elements.").arg(zones()));
+        return;
+    }
+    {
+        os::published<params_t>::editor p(params_);
+        p->power.assign(v.constData(), v.constData() + n);
+        p->powerSeq++;
+    }
+    emit propertiesChanged();
+}
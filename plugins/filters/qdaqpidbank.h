@@ -0,0 +1,134 @@
+#ifndef QDAQPIDBANK_H
+#define QDAQPIDBANK_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "QDaqVector.h"
+#include "os_util.h"
+
+#include <QMutex>
+
+#include <vector>
+
+/**
+ * @brief A bank of independent PID controllers.
+ *
+ * Controller i reads input channel i (process variable) and writes
+ * output channel i (control variable, e.g. heater power). The algorithm is
+ * the same as QDaqPid (isa_pid): set-point weighting beta, filtered
+ * derivative with Td/Nd, integrator anti-windup with tracking time Tr and
+ * bumpless switching to auto mode. The output is limited to [0, maxPower].
+ *
+ * The per-zone parameters (setPoint, gain, Ti, Td, Tr, beta, maxPower,
+ * power) are vectors. A vector with 1 element applies to all zones,
+ * otherwise it must have one element per zone. samplingPeriod, Nd and
+ * autoMode are common to all zones.
+ *
+ * The state and coefficients are stored as arrays over the zones
+ * (struct-of-arrays), so that all controllers are updated in one
+ * vectorizable loop. Parameters can be changed while the loop runs; they
+ * are adopted at the next repetition.
+ *
+ * Relay auto-tuning is not supported; use QDaqPid to tune a zone.
+ */
+class FILTERSSHARED_EXPORT QDaqPidBank :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// Number of controllers, equal to the number of input channels (read-only).
+    Q_PROPERTY(int zones READ zones)
+    /// Sampling period in s.
+    Q_PROPERTY(double samplingPeriod READ samplingPeriod WRITE setSamplingPeriod)
+    /// Derivative filter constant, the filter time constant is Td/Nd.
+    Q_PROPERTY(uint Nd READ Nd WRITE setNd)
+    /// Automatic control of all zones.
+    Q_PROPERTY(bool autoMode READ autoMode WRITE setAutoMode)
+    /// Set-points.
+    Q_PROPERTY(QDaqVector setPoint READ setPoint WRITE setSetPoint)
+    /// Proportional gains.
+    Q_PROPERTY(QDaqVector gain READ gain WRITE setGain)
+    /// Integration times in s (0 = no integral action).
+    Q_PROPERTY(QDaqVector Ti READ Ti WRITE setTi)
+    /// Derivative times in s.
+    Q_PROPERTY(QDaqVector Td READ Td WRITE setTd)
+    /// Anti-windup tracking times in s (0 = no tracking).
+    Q_PROPERTY(QDaqVector Tr READ Tr WRITE setTr)
+    /// Set-point weights.
+    Q_PROPERTY(QDaqVector beta READ beta WRITE setBeta)
+    /// Output limits.
+    Q_PROPERTY(QDaqVector maxPower READ maxPower WRITE setMaxPower)
+    /// Current outputs (the staged manual outputs if not armed). Writing sets the output of manual mode.
+    Q_PROPERTY(QDaqVector power READ power WRITE setPower)
+
+protected:
+    // Parameters set by the user, adopted in filterfunc().
+    // power is a command, applied only when powerSeq changes.
+    struct params_t {
+        double h;
+        int N;
+        bool autoMode;
+        std::vector<double> sp, k, ti, td, tr, b, umax, power;
+        uint powerSeq;
+    };
+    os::published<params_t> params_;
+    uint powerSeq_;
+    void adoptParams();
+
+    int zones_;
+    bool auto_, atp_;
+    // per-zone parameters and coefficients
+    std::vector<double> sp_, k_, b_, umax_, a1_, a2_, b1_, b2_;
+    // per-zone state
+    std::vector<double> ui_, ud_, pvp_, cv_;
+
+    // outputs published by the loop thread for power().
+    // The loop never waits; readLock_ only serializes the readers.
+    mutable os::triple_buffer< std::vector<double> > cvOut_;
+    mutable QMutex readLock_;
+
+    typedef std::vector<double> params_t::* param_ptr;
+    QDaqVector getParam(param_ptr m) const;
+    void setParam(param_ptr m, const QDaqVector& v);
+    // expand a vector of 1 or zones_ elements to zones_ elements
+    void expand(const std::vector<double>& src, std::vector<double>& dst) const;
+
+public:
+    Q_INVOKABLE explicit QDaqPidBank(const QString& name);
+
+    // getters
+    virtual int nInputChannels() const { return inputChannels().size(); }
+    virtual int nOutputChannels() const { return inputChannels().size(); }
+    int zones() const { return inputChannels().size(); }
+    double samplingPeriod() const { return params_.staged().h; }
+    uint Nd() const { return params_.staged().N; }
+    bool autoMode() const { return params_.staged().autoMode; }
+    QDaqVector setPoint() const { return getParam(&params_t::sp); }
+    QDaqVector gain() const { return getParam(&params_t::k); }
+    QDaqVector Ti() const { return getParam(&params_t::ti); }
+    QDaqVector Td() const { return getParam(&params_t::td); }
+    QDaqVector Tr() const { return getParam(&params_t::tr); }
+    QDaqVector beta() const { return getParam(&params_t::b); }
+    QDaqVector maxPower() const { return getParam(&params_t::umax); }
+    QDaqVector power() const;
+
+    // setters
+    void setSamplingPeriod(double v);
+    void setNd(uint v);
+    void setAutoMode(bool on);
+    void setSetPoint(const QDaqVector& v) { setParam(&params_t::sp, v); }
+    void setGain(const QDaqVector& v) { setParam(&params_t::k, v); }
+    void setTi(const QDaqVector& v) { setParam(&params_t::ti, v); }
+    void setTd(const QDaqVector& v) { setParam(&params_t::td, v); }
+    void setTr(const QDaqVector& v) { setParam(&params_t::tr, v); }
+    void setBeta(const QDaqVector& v) { setParam(&params_t::b, v); }
+    void setMaxPower(const QDaqVector& v) { setParam(&params_t::umax, v); }
+    void setPower(const QDaqVector& v);
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterfunc(const double* vin, double* vout);
+};
+
+#endif // QDAQPIDBANK_H
@@ -0,0 +1,220 @@
+#include "qdaqquantile.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QDaqQuantile::QDaqQuantile(const QString& name) :
+    QDaqFilter(name),
+    count_(0),
+    nout_(0),
+    clearSeq_(0)
+{
+    results_t r;
+    r.min = r.max = std::numeric_limits<double>::quiet_NaN();
+    r.count = 0;
+    out_.reset(r);
+    p_ << 0.05 << 0.5 << 0.95;
+    os::published<params_t>::editor p(params_);
+    p->clearSeq = clearSeq_;
+}
+
+void QDaqQuantile::adoptParams()
+{
+    if (!params_.adopt()) return;
+    const params_t& p = params_.current();
+
+    if (p.clearSeq != clearSeq_)
+    {
+        clearSeq_ = p.clearSeq;
+        count_ = 0;
+    }
+}
+
+void QDaqQuantile::setProbabilities(const QDaqVector& v)
+{
+    if (throwIfArmed()) return;
+    if (v.size()==0)
+    {
+        throwScriptError("At least one probability is needed.");
+        return;
+    }
+    for(int i=0; i<v.size(); ++i)
+        if (!(v[i] > 0. && v[i] < 1.) || (i && v[i] <= v[i-1]))
+        {
+            throwScriptError("Probabilities must be increasing and in (0,1).");
+            return;
+        }
+    p_ = v.clone();
+    emit propertiesChanged();
+}
+
+bool QDaqQuantile::filterinit()
+{
+    // markers: min, the quantiles, the midpoints between them, max
+    const int m = p_.size();
+    const int M = 2*m + 3;
+    dp_.assign(M, 0.);
+    for(int j=0; j<m; ++j)
+    {
+        double pl = j ? p_[j-1] : 0.;
+        dp_[2*j+1] = 0.5*(pl + p_[j]);
+        dp_[2*j+2] = p_[j];
+    }
+    dp_[M-2] = 0.5*(p_[m-1] + 1.);
+    dp_[M-1] = 1.;
+
+    q_.assign(M, 0.);
+    pos_.assign(M, 0.);
+    count_ = 0;
+    nout_ = nOutputChannels();
+
+    params_.adopt();
+    clearSeq_ = params_.current().clearSeq;
+
+    {
+        QMutexLocker L(&readLock_);
+        results_t r;
+        r.q.assign(m, 0.);
+        out_.reset(r);
+    }
+    publishResults();
+    return true;
+}
+
+void QDaqQuantile::add(double x)
+{
+    const int M = q_.size();
+    double* q = q_.data();
+    double* n = pos_.data();
+
+    // the first M samples are kept sorted
+    if (count_ < (uint)M)
+    {
+        double* e = q + count_;
+        double* i = std::upper_bound(q, e, x);
+        std::copy_backward(i, e, e + 1);
+        *i = x;
+        count_++;
+        if (count_ == (uint)M)
+            for(int i=0; i<M; ++i) n[i] = i + 1;
+        return;
+    }
+
+    // find the cell q[k] <= x < q[k+1]
+    int k;
+    if (x < q[0]) { q[0] = x; k = 0; }
+    else if (x >= q[M-1]) { q[M-1] = x; k = M-2; }
+    else k = int(std::upper_bound(q, q + M, x) - q) - 1;
+
+    for(int i=k+1; i<M; ++i) n[i] += 1.;
+    count_++;
+
+    // move the inner markers towards their desired positions
+    const double N1 = count_ - 1;
+    for(int i=1; i<M-1; ++i)
+    {
+        double d = 1. + N1*dp_[i] - n[i];
+        if ((d >= 1. && n[i+1] - n[i] > 1.) || (d <= -1. && n[i-1] - n[i] < -1.))
+        {
+            double s = d > 0. ? 1. : -1.;
+            // piecewise-parabolic prediction
+            double qp = q[i] + s/(n[i+1] - n[i-1]) *
+                    ((n[i] - n[i-1] + s)*(q[i+1] - q[i])/(n[i+1] - n[i]) +
+                     (n[i+1] - n[i] - s)*(q[i] - q[i-1])/(n[i] - n[i-1]));
+            if (q[i-1] < qp && qp < q[i+1]) q[i] = qp;
+            else {
+                // linear
+                int j = i + (int)s;
+                q[i] += s*(q[j] - q[i])/(n[j] - n[i]);
+            }
+            n[i] += s;
+        }
+    }
+}
+
+double QDaqQuantile::estimate(int j) const
+{
+    if (count_ == 0) return std::numeric_limits<double>::quiet_NaN();
+    if (count_ < q_.size())
+    {
+        // nearest rank of the sorted samples
+        int i = (int)std::floor(p_[j]*(count_ - 1) + 0.5);
+        return q_[i];
+    }
+    return q_[2*j+2];
+}
+
+bool QDaqQuantile::filterblock(const double* vin, double* vout, int n)
+{
+    adoptParams();
+
+    for(int j=0; j<n; ++j)
+    {
+        if (std::isfinite(vin[j])) add(vin[j]);
+        for(int k=0; k<nout_; ++k) vout[k*n + j] = estimate(k);
+    }
+
+    publishResults();
+    return true;
+}
+
+void QDaqQuantile::publishResults()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    results_t& r = out_.back();
+    for(size_t j=0; j<r.q.size(); ++j) r.q[j] = estimate(j);
+    r.min = count_ ? q_[0] : nan;
+    r.max = count_ ? (count_ < q_.size() ? q_[count_-1] : q_.back()) : nan;
+    r.count = count_;
+    out_.publish();
+}
+
+// call with readLock_ held
+const QDaqQuantile::results_t& QDaqQuantile::results() const
+{
+    out_.update();
+    return out_.read();
+}
+
+// getters
+QDaqVector QDaqQuantile::quantiles() const
+{
+    QMutexLocker L(&readLock_);
+    const std::vector<double>& q = results().q;
+    QDaqVector v;
+    v.push(q.data(), (int)q.size());
+    return v;
+}
+double QDaqQuantile::minimum() const
+{
+    QMutexLocker L(&readLock_);
+    return results().min;
+}
+double QDaqQuantile::maximum() const
+{
+    QMutexLocker L(&readLock_);
+    return results().max;
+}
+uint QDaqQuantile::count() const
+{
+    QMutexLocker L(&readLock_);
+    return results().count;
+}
+
+void QDaqQuantile::clear()
+{
+    {
+        os::published<params_t>::editor p(params_);
+        p->clearSeq++;
+    }
+    if (!armed())
+    {
+        QMutexLocker L(&readLock_);
+        count_ = 0;
+        publishResults();
+    }
+    emit propertiesChanged();
+}
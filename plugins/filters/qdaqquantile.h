@@ -0,0 +1,110 @@
+#ifndef QDAQQUANTILE_H
+#define QDAQQUANTILE_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "QDaqVector.h"
+#include "os_util.h"
+
+#include <QMutex>
+
+#include <vector>
+
+/**
+ * @brief Streaming quantile estimator.
+ *
+ * Estimates the quantiles of the input signal at the given probabilities
+ * (e.g. [0.05, 0.5, 0.95]) since arm or the last clear(), without storing
+ * the samples.
+ *
+ * The algorithm is the extended P-square method (Jain & Chlamtac, 1985;
+ * Raatikainen, 1987): 2m+3 markers track the minimum, the maximum, the m
+ * quantiles and the midpoints between them. Each sample moves the
+ * markers by at most one position and their heights are adjusted by
+ * piecewise-parabolic interpolation. Memory is constant and the cost per
+ * sample is a binary search plus one pass over the markers.
+ *
+ * Takes one input channel. If output channels are given, there must be one
+ * per probability and they receive the current estimates at each sample.
+ * Non-finite input values are ignored.
+ *
+ * The estimates cover all samples since the start. For quantiles of a
+ * decaying window use QDaqHistogram::quantile().
+ *
+ * The loop thread publishes the results once per repetition through a
+ * triple buffer, without locking; the getters read this copy.
+ */
+class FILTERSSHARED_EXPORT QDaqQuantile :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// Probabilities of the estimated quantiles, increasing, in (0,1).
+    Q_PROPERTY(QDaqVector probabilities READ probabilities WRITE setProbabilities)
+    /// Current quantile estimates (read-only).
+    Q_PROPERTY(QDaqVector quantiles READ quantiles)
+    /// Minimum of the input (read-only).
+    Q_PROPERTY(double minimum READ minimum)
+    /// Maximum of the input (read-only).
+    Q_PROPERTY(double maximum READ maximum)
+    /// Number of samples processed (read-only).
+    Q_PROPERTY(uint count READ count)
+
+protected:
+    QDaqVector p_;
+
+    // marker probabilities, heights and positions (1-based)
+    std::vector<double> dp_, q_, pos_;
+    uint count_;
+    int nout_;
+
+    // clear() is a command applied when clearSeq changes
+    struct params_t {
+        uint clearSeq;
+    };
+    os::published<params_t> params_;
+    uint clearSeq_;
+    void adoptParams();
+
+    void add(double x);
+    double estimate(int j) const;
+
+    // results published by the loop thread.
+    // The loop never waits; readLock_ only serializes the readers.
+    struct results_t {
+        std::vector<double> q;
+        double min, max;
+        uint count;
+    };
+    mutable os::triple_buffer<results_t> out_;
+    mutable QMutex readLock_;
+    void publishResults();
+    const results_t& results() const;
+
+public:
+    Q_INVOKABLE explicit QDaqQuantile(const QString& name);
+
+    // getters
+    virtual int nInputChannels() const { return 1; }
+    // none or one per probability
+    virtual int nOutputChannels() const { return outputChannels().isEmpty() ? 0 : p_.size(); }
+    QDaqVector probabilities() const { return p_; }
+    QDaqVector quantiles() const;
+    double minimum() const;
+    double maximum() const;
+    uint count() const;
+
+    // setters
+    void setProbabilities(const QDaqVector& v);
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterblock(const double* vin, double* vout, int n);
+
+public slots:
+    /// Restart the estimation.
+    void clear();
+};
+
+#endif // QDAQQUANTILE_H
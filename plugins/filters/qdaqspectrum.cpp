@@ -0,0 +1,301 @@
+#include "qdaqspectrum.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+QDaqSpectrum::QDaqSpectrum(const QString& name) :
+    QDaqFilter(name),
+    n_(1024),
+    window_(Hann),
+    overlap_(0.5),
+    averages_(4),
+    fs_(0.),
+    rate_(0.),
+    fill_(0), hop_(512),
+    wr_(0), rd_(0),
+    dropped_(0),
+    worker_(0),
+    quit_(0),
+    wavetable_(0),
+    workspace_(0),
+    s1_(1.), s2_(1.),
+    navg_(0),
+    count_(0)
+{
+}
+
+QDaqSpectrum::~QDaqSpectrum()
+{
+    stopWorker();
+}
+
+// setters
+void QDaqSpectrum::setFftLength(uint n)
+{
+    if (throwIfArmed()) return;
+    if (n < 8)
+    {
+        throwScriptError("fftLength must be at least 8.");
+        return;
+    }
+    if (n_ != n)
+    {
+        n_ = n;
+        emit propertiesChanged();
+    }
+}
+void QDaqSpectrum::setWindow(WindowType w)
+{
+    if (throwIfArmed()) return;
+    if ((int)w==-1)
+    {
+        throwScriptError("Invalid window specification. Availiable options: "
+                         "Rectangular, Hann, Hamming, Blackman, FlatTop");
+        return;
+    }
+    if (window_ != w)
+    {
+        window_ = w;
+        emit propertiesChanged();
+    }
+}
+void QDaqSpectrum::setOverlap(double v)
+{
+    if (throwIfArmed()) return;
+    if (v < 0. || v >= 1.)
+    {
+        throwScriptError("overlap must be in [0, 1).");
+        return;
+    }
+    if (overlap_ != v)
+    {
+        overlap_ = v;
+        emit propertiesChanged();
+    }
+}
+void QDaqSpectrum::setAverages(uint n)
+{
+    if (throwIfArmed()) return;
+    if (n < 1)
+    {
+        throwScriptError("averages must be at least 1.");
+        return;
+    }
+    if (averages_ != n)
+    {
+        averages_ = n;
+        emit propertiesChanged();
+    }
+}
+void QDaqSpectrum::setSamplingRate(double f)
+{
+    if (throwIfArmed()) return;
+    if (f < 0.)
+    {
+        throwScriptError("Sampling rate must be >= 0.");
+        return;
+    }
+    if (fs_ != f)
+    {
+        fs_ = f;
+        emit propertiesChanged();
+    }
+}
+
+// getters
+QDaqVector QDaqSpectrum::frequencies() const
+{
+    QDaqVector v;
+    if (rate_ > 0.)
+        for(uint k=0; k<=n_/2; ++k) v.push(k*rate_/n_);
+    return v;
+}
+QDaqVector QDaqSpectrum::magnitude() const
+{
+    QMutexLocker L(&resultLock_);
+    QDaqVector v;
+    v.push(magOut_.data(), (int)magOut_.size());
+    return v;
+}
+QDaqVector QDaqSpectrum::psd() const
+{
+    QMutexLocker L(&resultLock_);
+    QDaqVector v;
+    v.push(psdOut_.data(), (int)psdOut_.size());
+    return v;
+}
+uint QDaqSpectrum::count() const
+{
+    QMutexLocker L(&resultLock_);
+    return count_;
+}
+
+bool QDaqSpectrum::filterinit()
+{
+    stopWorker();
+
+    rate_ = fs_ > 0. ? fs_ : (top_ && top_->period() ? 1000.*blockSize_/top_->period() : 0.);
+    if (rate_ <= 0.)
+    {
+        throwScriptError("Unknown sampling rate.");
+        return false;
+    }
+
+    const uint N = n_;
+    hop_ = (uint)std::floor(N*(1. - overlap_) + 0.5);
+    if (hop_ < 1) hop_ = 1;
+    if (hop_ > N) hop_ = N;
+    seg_.assign(N, 0.);
+    fill_ = 0;
+
+    queue_.assign(QueueSize*N, 0.);
+    wr_.store(0);
+    rd_.store(0);
+    pending_.tryAcquire(pending_.available());
+    dropped_.store(0);
+
+    // window function (periodic form) and its sums
+    w_.resize(N);
+    s1_ = s2_ = 0.;
+    for(uint i=0; i<N; ++i)
+    {
+        double c = 2*M_PI*i/N;
+        double w = 1.;
+        switch(window_)
+        {
+        case Rectangular: w = 1.; break;
+        case Hann: w = 0.5 - 0.5*std::cos(c); break;
+        case Hamming: w = 0.54 - 0.46*std::cos(c); break;
+        case Blackman: w = 0.42 - 0.5*std::cos(c) + 0.08*std::cos(2*c); break;
+        case FlatTop:
+            w = 0.21557895 - 0.41663158*std::cos(c) + 0.277263158*std::cos(2*c)
+                    - 0.083578947*std::cos(3*c) + 0.006947368*std::cos(4*c);
+            break;
+        }
+        w_[i] = w;
+        s1_ += w;
+        s2_ += w*w;
+    }
+
+    wavetable_ = gsl_fft_real_wavetable_alloc(N);
+    workspace_ = gsl_fft_real_workspace_alloc(N);
+    x_.assign(N, 0.);
+    acc_.assign(N/2 + 1, 0.);
+    mag_.assign(N/2 + 1, 0.);
+    psd_.assign(N/2 + 1, 0.);
+    navg_ = 0;
+    {
+        QMutexLocker L(&resultLock_);
+        magOut_.assign(N/2 + 1, 0.);
+        psdOut_.assign(N/2 + 1, 0.);
+        count_ = 0;
+    }
+
+    quit_.store(0);
+    worker_ = new Worker(this);
+    worker_->start();
+    return true;
+}
+
+void QDaqSpectrum::disarm_()
+{
+    stopWorker();
+    QDaqFilter::disarm_();
+}
+
+void QDaqSpectrum::stopWorker()
+{
+    if (worker_)
+    {
+        quit_.store(1);
+        pending_.release();
+        worker_->wait();
+        delete worker_;
+        worker_ = 0;
+    }
+    if (wavetable_) { gsl_fft_real_wavetable_free(wavetable_); wavetable_ = 0; }
+    if (workspace_) { gsl_fft_real_workspace_free(workspace_); workspace_ = 0; }
+}
+
+bool QDaqSpectrum::filterblock(const double* vin, double* vout, int n)
+{
+    Q_UNUSED(vout);
+
+    const uint N = n_;
+    for(int j=0; j<n; ++j)
+    {
+        seg_[fill_++] = vin[j];
+        if (fill_ < N) continue;
+
+        // segment complete: hand it to the worker if there is space
+        uint w = wr_.load();
+        if (w - (uint)rd_.loadAcquire() < (uint)QueueSize)
+        {
+            std::copy(seg_.begin(), seg_.end(), queue_.begin() + (w % QueueSize)*N);
+            wr_.storeRelease(w + 1);
+            pending_.release();
+        }
+        else dropped_.ref();
+
+        // keep the overlapping part
+        std::copy(seg_.begin() + hop_, seg_.end(), seg_.begin());
+        fill_ = N - hop_;
+    }
+
+    return true;
+}
+
+void QDaqSpectrum::work()
+{
+    for(;;)
+    {
+        pending_.acquire();
+        if (quit_.load()) break;
+        uint r = rd_.load();
+        process(&queue_[(r % QueueSize)*n_]);
+        rd_.storeRelease(r + 1);
+    }
+}
+
+void QDaqSpectrum::process(const double* x)
+{
+    const uint N = n_;
+    double* y = x_.data();
+    for(uint i=0; i<N; ++i) y[i] = x[i]*w_[i];
+
+    // halfcomplex result: y[0] = Re0, y[2k-1] = Re_k, y[2k] = Im_k,
+    // y[N-1] = Re_N/2 for even N
+    gsl_fft_real_transform(y, 1, N, wavetable_, workspace_);
+
+    acc_[0] += y[0]*y[0];
+    for(uint k=1; 2*k<N; ++k)
+        acc_[k] += y[2*k-1]*y[2*k-1] + y[2*k]*y[2*k];
+    if (N%2==0) acc_[N/2] += y[N-1]*y[N-1];
+
+    if (++navg_ < averages_) return;
+
+    // one-sided spectra
+    for(uint k=0; k<=N/2; ++k)
+    {
+        double p = acc_[k]/navg_;
+        double f = (k==0 || 2*k==N) ? 1. : 2.;
+        psd_[k] = f*p/(rate_*s2_);
+        mag_[k] = f*std::sqrt(p)/s1_;
+    }
+    {
+        QMutexLocker L(&resultLock_);
+        magOut_.swap(mag_);
+        psdOut_.swap(psd_);
+        count_++;
+    }
+    std::fill(acc_.begin(), acc_.end(), 0.);
+    navg_ = 0;
+
+    notify(NotifyProperties);
+}
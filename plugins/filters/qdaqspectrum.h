@@ -0,0 +1,158 @@
+#ifndef QDAQSPECTRUM_H
+#define QDAQSPECTRUM_H
+
+#include "filters_global.h"
+
+#include "QDaqFilter.h"
+#include "QDaqVector.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+
+#include <vector>
+
+#include <gsl/gsl_fft_real.h>
+
+/**
+ * @brief Streaming spectrum analyzer (Welch method).
+ *
+ * Takes one input channel and no output channels.
+ *
+ * The input is split into segments of fftLength samples that overlap
+ * by the given fraction. Each segment is multiplied by the window
+ * function and Fourier transformed. The squared magnitudes of averages
+ * segments are averaged, then the result is published in the
+ * magnitude and psd properties and a new average is started.
+ * Thus a new spectrum is available every
+ * averages*(1-overlap)*fftLength/samplingRate seconds.
+ *
+ * The loop thread only copies completed segments to a small queue.
+ * The transforms are done by a background worker thread, so that the loop
+ * is never blocked. If the worker cannot keep up, segments are dropped
+ * and counted in the dropped property.
+ *
+ * The transforms use the GSL mixed-radix real FFT, with the trigonometric
+ * tables computed at arm, so any fftLength is possible; powers of 2 and
+ * products of small primes are fastest.
+ *
+ * magnitude is the one-sided amplitude spectrum, calibrated so that a sine
+ * of amplitude A gives a peak of height A. psd is the one-sided power
+ * spectral density in units^2/Hz.
+ */
+class FILTERSSHARED_EXPORT QDaqSpectrum :
+        public QDaqFilter
+{
+    Q_OBJECT
+
+    /// Number of samples per segment.
+    Q_PROPERTY(uint fftLength READ fftLength WRITE setFftLength)
+    /// Window function: Rectangular, Hann, Hamming, Blackman, FlatTop.
+    Q_PROPERTY(WindowType window READ window WRITE setWindow)
+    /// Fraction of overlap between consecutive segments, 0 <= overlap < 1.
+    Q_PROPERTY(double overlap READ overlap WRITE setOverlap)
+    /// Number of segments averaged in each spectrum.
+    Q_PROPERTY(uint averages READ averages WRITE setAverages)
+    /// Sampling rate in Hz. If 0 the sampling rate of the loop is used.
+    Q_PROPERTY(double samplingRate READ samplingRate WRITE setSamplingRate)
+    /// Frequencies in Hz of the spectrum points (read-only).
+    Q_PROPERTY(QDaqVector frequencies READ frequencies)
+    /// Amplitude spectrum (read-only).
+    Q_PROPERTY(QDaqVector magnitude READ magnitude)
+    /// Power spectral density in units^2/Hz (read-only).
+    Q_PROPERTY(QDaqVector psd READ psd)
+    /// Number of spectra published since arm (read-only).
+    Q_PROPERTY(uint count READ count)
+    /// Number of segments dropped because the worker was busy (read-only).
+    Q_PROPERTY(uint dropped READ dropped)
+
+public:
+    enum WindowType {
+        Rectangular,
+        Hann,
+        Hamming,
+        Blackman,
+        FlatTop
+    };
+    Q_ENUM(WindowType)
+
+protected:
+    uint n_;
+    WindowType window_;
+    double overlap_;
+    uint averages_;
+    double fs_;
+    // sampling rate in use, set at arm
+    double rate_;
+
+    // loop thread: samples of the current segment
+    std::vector<double> seg_;
+    uint fill_, hop_;
+
+    // segments waiting for the worker
+    enum { QueueSize = 4 };
+    std::vector<double> queue_;
+    QAtomicInt wr_, rd_;
+    QSemaphore pending_;
+    QAtomicInt dropped_;
+
+    // worker thread
+    class Worker : public QThread
+    {
+        QDaqSpectrum* s_;
+    protected:
+        virtual void run() { s_->work(); }
+    public:
+        explicit Worker(QDaqSpectrum* s) : s_(s) {}
+    };
+    Worker* worker_;
+    QAtomicInt quit_;
+    gsl_fft_real_wavetable* wavetable_;
+    gsl_fft_real_workspace* workspace_;
+    std::vector<double> w_, x_, acc_;
+    // sums of the window and of its square
+    double s1_, s2_;
+    uint navg_;
+    void work();
+    void process(const double* x);
+
+    // published results
+    mutable QMutex resultLock_;
+    std::vector<double> mag_, psd_, magOut_, psdOut_;
+    uint count_;
+
+    void stopWorker();
+
+public:
+    Q_INVOKABLE explicit QDaqSpectrum(const QString& name);
+    virtual ~QDaqSpectrum();
+
+    // getters
+    virtual int nInputChannels() const { return 1; }
+    virtual int nOutputChannels() const { return 0; }
+    uint fftLength() const { return n_; }
+    WindowType window() const { return window_; }
+    double overlap() const { return overlap_; }
+    uint averages() const { return averages_; }
+    double samplingRate() const { return fs_; }
+    QDaqVector frequencies() const;
+    QDaqVector magnitude() const;
+    QDaqVector psd() const;
+    uint count() const;
+    uint dropped() const { return dropped_.load(); }
+
+    // setters
+    void setFftLength(uint n);
+    void setWindow(WindowType w);
+    void setOverlap(double v);
+    void setAverages(uint n);
+    void setSamplingRate(double f);
+
+protected:
+    virtual bool filterinit();
+    virtual bool filterblock(const double* vin, double* vout, int n);
+    virtual void disarm_();
+};
+
+#endif // QDAQSPECTRUM_H
@@ -1,4 +1,10 @@
 #include "qdaqserial.h"
+#include "QDaqJob.h"
+
+#include <QElapsedTimer>
+
+// max time blocked without checking for cancellation (ms)
+#define WAIT_SLICE 10
 
 QDaqSerial::QDaqSerial(const QString &name, const QString &portName) :
     QDaqInterface(name)
@@ -77,7 +83,7 @@ int QDaqSerial::read(uint port, char* buff, int len, int eos)
     char c;
     char eos_char = eos & 0xFF;
     bool ok;
-    while ( (ok = port_->waitForReadyRead(timeout())) )
+    while ( (ok = (port_->bytesAvailable() || waitForReadyRead_())) )
     {
         port_->read(&c,1);
         buff[read++] = c;
@@ -90,7 +96,8 @@ int QDaqSerial::read(uint port, char* buff, int len, int eos)
     }
     if (!ok)
     {
-        pushError("Read char failed", "possibly timed-out");
+        pushError("Read char failed",
+                  QDaqJob::cancelRequested() ? "time budget exceeded" : "possibly timed-out");
     }
     return ok ? read : 0;
 }
@@ -107,7 +114,7 @@ int QDaqSerial::write(uint port, const char* buff, int len, int eos)
 
     port_->write(buff,len);
     port_->write(&eos_char,1);
-    bool ok = port_->waitForBytesWritten(timeout());
+    bool ok = waitForBytesWritten_();
 
     if (!ok)
     {
@@ -116,6 +123,33 @@ int QDaqSerial::write(uint port, const char* buff, int len, int eos)
     return ok ? len : 0;
 }
 
+bool QDaqSerial::waitForReadyRead_()
+{
+    QElapsedTimer t;
+    t.start();
+    int left;
+    while ((left = timeout() - t.elapsed()) > 0)
+    {
+        if (port_->waitForReadyRead(qMin(left, WAIT_SLICE))) return true;
+        if (QDaqJob::cancelRequested()) return false;
+    }
+    return false;
+}
+
+bool QDaqSerial::waitForBytesWritten_()
+{
+    QElapsedTimer t;
+    t.start();
+    int left;
+    while ((left = timeout() - t.elapsed()) > 0)
+    {
+        if (port_->waitForBytesWritten(qMin(left, WAIT_SLICE))) return true;
+        if (!port_->bytesToWrite()) return true;
+        if (QDaqJob::cancelRequested()) return false;
+    }
+    return false;
+}
+
 bool QDaqSerial::open_()
 {
     if (isOpen()) return true;
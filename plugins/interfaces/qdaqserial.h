@@ -76,6 +76,11 @@ protected:
     virtual bool open_();
     virtual void close_();
     virtual void clear_();
+
+    // wait up to timeout() in short slices, abort if the calling
+    // job's time budget expires (see QDaqJob::cancelRequested())
+    bool waitForReadyRead_();
+    bool waitForBytesWritten_();
 };
 
 #endif // QDAQSERIAL_H
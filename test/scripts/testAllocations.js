@@ -0,0 +1,35 @@
+print("Allocation diagnostics and notifications");
+
+// a channel that does not allocate in steady state and a job that does
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+loop.limit = 100;
+var rand = new QDaqChannel("rand");
+rand.type = "Random";
+var alloc = new QDaqJob("alloc");
+alloc.runCode = "var a = []; for(var i=0; i<100; i++) a.push({ x: i });";
+loop.appendChild(rand);
+loop.appendChild(alloc);
+qdaq.appendChild(loop);
+
+// the notifications of rand are delivered by the root every 40 ms,
+// coalescing the requests made in between
+var nwidgets = 0;
+rand.updateWidgets.connect(function() { nwidgets++; });
+
+loop.arm();
+while(loop.armed) wait(100);
+wait(100);
+
+print(loop.allocReport());
+if (loop.tickAllocations == 0 && alloc.allocations == 0) {
+    // expected unless built with CONFIG+=alloc_diagnostics
+    print("Allocations are not counted in this build.");
+} else {
+    print("tickAllocations = " + loop.tickAllocations + " (expected > 0)");
+    print("rand.allocations = " + rand.allocations + " (expected 0)");
+    print("alloc.allocations = " + alloc.allocations + " (expected > 0)");
+}
+
+// 100 repetitions in about 1 s
+print("rand.updateWidgets emitted " + nwidgets + " times (expected about 25, less than 100)");
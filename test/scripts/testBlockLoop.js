@@ -0,0 +1,43 @@
+print("Creating block mode loop");
+
+// a loop processing 10 samples per repetition
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.blockSize = 10;
+
+// a clock channel
+var t = new QDaqChannel("t");
+t.type = "Clock";
+// an incrementing channel
+var ch1 = new QDaqChannel("ch1");
+ch1.type = "Inc";
+// a channel fed by a script job, 10 values per repetition,
+// averaged per sample
+var ch2 = new QDaqChannel("ch2");
+ch2.averaging = "Running";
+ch2.depth = 4;
+var scr = new QDaqJob("scr");
+scr.runCode = "this.ch2.push(Math.random());"
+scr.appendChild(ch2);
+
+// a buffer collecting one row per sample
+var buff = new QDaqDataBuffer("buff");
+buff.channels = [t, ch1, ch2];
+
+loop.appendChild(t);
+loop.appendChild(ch1);
+loop.appendChild(scr);
+loop.appendChild(buff);
+qdaq.appendChild(loop);
+
+loop.createLoopEngine();
+
+print("Tree = \n" + qdaq.objectTree());
+
+loop.limit = 10;
+loop.arm();
+wait(1500);
+
+// expect 100 rows, ch1 increments by 1 per row
+print("Rows = " + buff.size);
+print("ch1 = " + buff.ch1);
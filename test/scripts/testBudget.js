@@ -0,0 +1,43 @@
+print("Time budgets and overrun policies");
+
+// a job that busy-waits 20 ms per repetition, with a 5 ms budget
+var loop = new QDaqLoop("loop");
+loop.period = 50;
+var job = new QDaqJob("job");
+job.runCode = "var t0 = Date.now(); while (Date.now() - t0 < 20) ;";
+job.budget = 5;
+// a child channel counting its repetitions
+var ch = new QDaqChannel("ch");
+ch.type = "Inc";
+job.appendChild(ch);
+loop.appendChild(job);
+qdaq.appendChild(loop);
+
+loop.createLoopEngine();
+
+function runPolicy(policy) {
+    job.overrunPolicy = policy;
+    var c0 = ch.value;
+    loop.limit = 20;
+    loop.arm();
+    wait(1500);
+    if (loop.armed) loop.disarm();
+    print(policy + ": overruns = " + job.overruns + ", skipped = " + job.skipped +
+          ", child ran " + (ch.value - c0) + " times, ch.dataReady = " + ch.dataReady);
+}
+
+// expected: 20 overruns, 0 skipped, child ran 20 times
+runPolicy("Flag");
+// expected: the job runs at repetitions 1, 3, 6, 11, 20 and backs off
+// 1, 2, 4, 8 repetitions in between: 5 overruns, 15 skipped, child ran 0 times
+runPolicy("Skip");
+// expected: 20 overruns, 0 skipped, child ran 0 times, ch.dataReady = false
+runPolicy("NotReady");
+// expected: 1 overrun, the loop is disarmed with an error
+runPolicy("Disarm");
+print("loop.armed = " + loop.armed + " (expected false)");
+
+// within budget the job is never skipped
+job.runCode = "";
+// expected: 0 overruns, 0 skipped, child ran 20 times
+runPolicy("Skip");
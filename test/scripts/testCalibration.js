@@ -0,0 +1,35 @@
+print("Channel calibration");
+
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.limit = 5;
+
+// a type K thermocouple reading 4.096 mV - 1.000 mV (cold junction at 25 degC)
+var tc = new QDaqChannel("tc");
+tc.calibration = "TypeK";
+tc.coldJunction = 25;
+tc.runCode = "this.push(3.096);";
+
+// a Pt100 at 138.5055 Ohm
+var rtd = new QDaqChannel("rtd");
+rtd.calibration = "Rtd";
+rtd.runCode = "this.push(138.5055);";
+
+// piecewise linear: y = x for x<1, y = 1 + 2(x-1) for 1<=x<2
+var pw = new QDaqChannel("pw");
+pw.calibration = "Piecewise";
+pw.calibrationBreakpoints = [0, 1, 2];
+pw.calibrationCoefficients = [0, 1, 1, 2];
+pw.runCode = "this.push(1.5);";
+
+loop.appendChild(tc);
+loop.appendChild(rtd);
+loop.appendChild(pw);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("TypeK (expected ~100) = " + tc.value());
+print("Pt100 (expected 100) = " + rtd.value());
+print("Piecewise (expected 2) = " + pw.value());
@@ -0,0 +1,67 @@
+print("Creating a bank of 256 channels");
+
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+
+// the bank's runCode pushes a scan at each repetition
+var bank = new QDaqChannelBank("bank");
+bank.size = 256;
+bank.averaging = "Running";
+bank.depth = 10;
+bank.runCode = "var x = []; for(var i=0; i<this.size; i++) x.push(i + Math.random()); this.push(x);";
+
+// the bank channels are normal channels for scaling and recording
+bank.ch1.multiplier = 2;
+bank.ch2.offset = -100;
+bank.ch3.range = [0, 1];
+
+var buff = new QDaqDataBuffer("buff");
+buff.channels = [bank.ch0, bank.ch1, bank.ch2, bank.ch3, bank.channel(255)];
+
+loop.appendChild(bank);
+loop.appendChild(buff);
+qdaq.appendChild(loop);
+
+loop.limit = 20;
+loop.arm();
+wait(2500);
+
+print("Scans processed = " + bank.count);
+print("ch0..ch3 = " + [bank.ch0.value(), bank.ch1.value(), bank.ch2.value(), bank.ch3.value()]);
+print("ch255 = " + bank.ch255.value() + " +- " + bank.ch255.std());
+print("Buffer size = " + buff.size);
+
+// scaling can change while the bank runs
+bank.ch1.multiplier = 3;
+loop.limit = 5;
+loop.arm();
+wait(1000);
+print("ch1 = " + bank.ch1.value() + " (expected ~3)");
+
+print("Block mode: 10 scans per repetition");
+
+var bloop = new QDaqLoop("bloop");
+bloop.period = 100;
+bloop.blockSize = 10;
+
+var bbank = new QDaqChannelBank("bbank");
+bbank.size = 512;
+bbank.runCode = "for(var k=0; k<10; k++) { var x = []; for(var i=0; i<this.size; i++) x.push(i + 0.01*k); this.push(x); }";
+
+var bbuff = new QDaqDataBuffer("bbuff");
+bbuff.channels = [bbank.ch0, bbank.ch511];
+
+bloop.appendChild(bbank);
+bloop.appendChild(bbuff);
+qdaq.appendChild(bloop);
+
+bloop.createLoopEngine();
+
+bloop.limit = 10;
+bloop.arm();
+wait(1500);
+
+// expect 100 scans and rows, ch0 steps by 0.01 within each block
+print("Scans processed = " + bbank.count + " (expected 100)");
+print("Buffer size = " + bbuff.size + " (expected 100)");
+print("ch0 = " + bbuff.ch0);
@@ -0,0 +1,55 @@
+print("Compiled vs generic channel processing");
+
+// the same recorded data go through pairs of channels with
+// identical settings, one compiled and one generic
+var N = 500; // channel pairs
+var data = [];
+for(var i=0; i<2000; i++) data.push(Math.sin(0.01*i) + 0.1*Math.random());
+
+var averaging = ["None", "Running", "Delta", "ForgettingFactor", "Median"];
+
+function makeLoop(name, compiled) {
+    var loop = new QDaqLoop(name);
+    loop.period = 10;
+    loop.virtualTime = true;
+    for(var i=0; i<N; i++) {
+        var ch = new QDaqChannel("ch" + i);
+        ch.type = "Playback";
+        ch.playbackData = data;
+        ch.averaging = averaging[i % averaging.length];
+        ch.depth = 1 + (i % 50);
+        if (i % 3 == 1) { ch.multiplier = 2; ch.offset = -1; }
+        if (i % 7 == 2) ch.parserExpression = "x^2";
+        ch.compiled = compiled;
+        loop.appendChild(ch);
+    }
+    qdaq.appendChild(loop);
+    return loop;
+}
+
+function runLoop(loop) {
+    var t0 = new Date();
+    loop.arm();
+    while(loop.armed) wait(10);
+    return (new Date() - t0);
+}
+
+var a = makeLoop("compiledLoop", true);
+var b = makeLoop("genericLoop", false);
+
+var ta = runLoop(a);
+var tb = runLoop(b);
+
+var chA = a.children(), chB = b.children();
+var diff = 0;
+for(var i=0; i<N; i++) {
+    var d = Math.abs(chA[i].value() - chB[i].value()) + Math.abs(chA[i].std() - chB[i].std());
+    if (d > diff) diff = d;
+}
+
+print("Max difference = " + diff);
+print("Compiled (ms) = " + ta);
+print("Generic (ms) = " + tb);
+
+qdaq.removeChild(a);
+qdaq.removeChild(b);
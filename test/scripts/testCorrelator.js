@@ -0,0 +1,36 @@
+print("Sliding-window linear regression");
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+loop.limit = 500;
+
+var t = new QDaqChannel("t");
+t.type = "Clock";
+
+// y = 1 + 2 t + noise
+var y = new QDaqChannel("y");
+y.runCode = "this.push(1 + 2*loop.t.value() + 0.01*(Math.random() - 0.5));";
+
+var a = new QDaqChannel("a");
+var b = new QDaqChannel("b");
+var r2 = new QDaqChannel("r2");
+r2.digits = 6;
+var sres = new QDaqChannel("sres");
+
+// 4 outputs: a, b, r^2, residual std
+var corr = new QDaqLinearCorrelator("corr");
+corr.inputChannels = [t, y];
+corr.outputChannels = [a, b, r2, sres];
+corr.size = 200;
+
+loop.appendChild(t);
+loop.appendChild(y);
+loop.appendChild(corr);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("b (expected 2) = " + b.value());
+print("r2 (expected ~1) = " + r2.value());
+print("residual std (expected ~0.003) = " + sres.value());
@@ -0,0 +1,57 @@
+print("IIR and FIR digital filters");
+
+// block mode loop on a simulated clock: 1 kHz sampling
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.blockSize = 100;
+loop.virtualTime = true;
+loop.limit = 50;
+
+// 5 Hz signal + 200 Hz interference
+var s1 = new QDaqGenerator("s1");
+s1.waveform = "Sine";
+s1.frequency = 5;
+var s2 = new QDaqGenerator("s2");
+s2.waveform = "Sine";
+s2.frequency = 200;
+s2.amplitude = 0.5;
+
+// both channels through the same 4th order Butterworth low-pass
+var lp1 = new QDaqChannel("lp1");
+var lp2 = new QDaqChannel("lp2");
+var iir = new QDaqIirFilter("iir");
+iir.type = "Lowpass";
+iir.design = "Butterworth";
+iir.order = 4;
+iir.frequency = 20;
+iir.inputChannels = [s1, s2];
+iir.outputChannels = [lp1, lp2];
+
+// 51-tap moving average by FFT
+var taps = [];
+for(var i=0; i<51; i++) taps.push(1/51);
+var ma = new QDaqChannel("ma");
+var fir = new QDaqFirFilter("fir");
+fir.taps = taps;
+fir.useFft = true;
+fir.inputChannels = [s2];
+fir.outputChannels = [ma];
+
+var buff = new QDaqDataBuffer("buff");
+buff.capacity = 5000;
+buff.channels = [s1, s2, lp1, lp2, ma];
+
+loop.appendChild(s1);
+loop.appendChild(s2);
+loop.appendChild(iir);
+loop.appendChild(fir);
+loop.appendChild(buff);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("sections = " + iir.sections);
+print("5 Hz after low-pass, std (expected ~0.71) = " + buff.lp1.std());
+print("200 Hz after low-pass, std (expected ~0) = " + buff.lp2.std());
+print("200 Hz after moving average, std (expected ~0.007) = " + buff.ma.std());
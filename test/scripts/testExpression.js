@@ -0,0 +1,58 @@
+print("Channel expressions referencing other channels");
+
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.blockSize = 10;
+loop.virtualTime = true;
+loop.limit = 20;
+
+var a = new QDaqGenerator("a");
+a.waveform = "Sine";
+var b = new QDaqGenerator("b");
+b.waveform = "Sine";
+b.frequency = 1;
+b.seed = 1;
+
+// magnitude of (a, b), evaluated once per block
+var r = new QDaqChannel("r");
+r.parserExpression = "sqrt(loop.a^2 + loop.b^2)";
+
+// x is the channel's own (averaged) value
+var s = new QDaqChannel("s");
+s.type = "Inc";
+s.parserExpression = "x + loop.a";
+
+var buff = new QDaqDataBuffer("buff");
+buff.capacity = 1000;
+buff.channels = [a, b, r, s];
+
+loop.appendChild(a);
+loop.appendChild(b);
+loop.appendChild(r);
+loop.appendChild(s);
+loop.appendChild(buff);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("Rows = " + buff.size);
+print("r = " + r.value() + ", expected " + Math.sqrt(a.value()*a.value() + b.value()*b.value()));
+
+// the same quantity as a virtual channel: computed only when read
+var rv = new QDaqVirtualChannel("rv");
+rv.expression = "sqrt(loop.a^2 + loop.b^2)";
+qdaq.appendChild(rv);
+print("rv sources = " + rv.sources);
+print("rv = " + rv.value() + " (seq " + rv.sequence() + ")");
+print("rv again = " + rv.value() + " (seq " + rv.sequence() + ", unchanged)");
+
+// virtual channels that refer to each other are rejected when first read
+var va = new QDaqVirtualChannel("va");
+var vb = new QDaqVirtualChannel("vb");
+qdaq.appendChild(va);
+qdaq.appendChild(vb);
+va.expression = "vb + 1";
+vb.expression = "va + 1";
+print("va = " + va.value() + " (not ready, circular reference)");
+print("vb = " + vb.value() + " (not ready, circular reference)");
@@ -0,0 +1,46 @@
+print("Synthetic signal generators");
+
+// a block mode loop on a simulated clock: 1 kHz sampling
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.blockSize = 100;
+loop.virtualTime = true;
+loop.limit = 50;
+
+var t = new QDaqChannel("t");
+t.type = "Clock";
+
+var sine = new QDaqGenerator("sine");
+sine.waveform = "Sine";
+sine.frequency = 5;
+sine.noise = 0.05;
+
+var chirp = new QDaqGenerator("chirp");
+chirp.waveform = "Chirp";
+chirp.frequency = 1;
+chirp.frequency2 = 50;
+chirp.sweepTime = 2;
+
+var noise = new QDaqGenerator("noise");
+noise.waveform = "Gaussian";
+noise.amplitude = 0.1;
+noise.drift = 1;
+noise.seed = 12345;
+
+var buff = new QDaqDataBuffer("buff");
+buff.capacity = 5000;
+buff.channels = [t, sine, chirp, noise];
+
+loop.appendChild(t);
+loop.appendChild(sine);
+loop.appendChild(chirp);
+loop.appendChild(noise);
+loop.appendChild(buff);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("Rows = " + buff.size);
+print("sine mean = " + buff.sine.mean() + ", std = " + buff.sine.std());
+print("noise (seed 12345) last value = " + noise.value());
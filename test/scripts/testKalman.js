@@ -0,0 +1,58 @@
+print("Kalman filter: position and velocity from a noisy and a slow sensor");
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+loop.limit = 1000;
+
+// time in s since the first sample. The filter starts from x0 = 0 with
+// P0 = I, which is consistent with the true state (1, 0.5) near t = 0.
+// Epoch time would put the true state far outside that prior.
+var clk = new QDaqChannel("clk");
+clk.type = "Clock";
+var t = new QDaqChannel("t");
+t.runCode = "if (typeof t0 == 'undefined') t0 = loop.clk.value(); this.push(loop.clk.value() - t0);";
+
+// x = 1 + 0.5 t
+// z1: every sample, std 0.1
+var z1 = new QDaqChannel("z1");
+z1.runCode = "this.push(1 + 0.5*loop.t.value() + 0.1*Math.sqrt(12)*(Math.random() - 0.5));";
+// z2: every 10th sample, std 0.01, NaN otherwise
+var z2 = new QDaqChannel("z2");
+z2.runCode = "this.push(Math.round(100*loop.t.value()) % 10 ? NaN : " +
+        "1 + 0.5*loop.t.value() + 0.01*Math.sqrt(12)*(Math.random() - 0.5));";
+
+var x = new QDaqChannel("x");
+x.digits = 4;
+var v = new QDaqChannel("v");
+v.digits = 4;
+var sx = new QDaqChannel("sx");
+var sv = new QDaqChannel("sv");
+
+// constant velocity model with dt = 0.01 s
+var kf = new QDaqKalman("kf");
+kf.F = [1, 0.01,
+        0, 1];
+kf.H = [1, 0,
+        1, 0];
+kf.Q = [1e-8, 0,
+        0, 1e-6];
+kf.R = [1e-2, 1e-4];
+kf.inputChannels = [z1, z2];
+kf.outputChannels = [x, v, sx, sv];
+
+loop.appendChild(clk);
+loop.appendChild(t);
+loop.appendChild(z1);
+loop.appendChild(z2);
+loop.appendChild(kf);
+loop.appendChild(x);
+loop.appendChild(v);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("states = " + kf.states);
+print("x = " + x.value() + " +- " + sx.value() + " (expected " + (1 + 0.5*t.value()) + ")");
+print("v = " + v.value() + " +- " + sv.value() + " (expected 0.5)");
+print("state = " + kf.state.toArray());
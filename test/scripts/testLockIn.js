@@ -0,0 +1,43 @@
+print("Digital lock-in amplifier");
+
+// block mode loop on a simulated clock: 10 kHz sampling
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.blockSize = 1000;
+loop.virtualTime = true;
+loop.limit = 50;
+
+// reference: 137 Hz, signal: 1 mV at the same frequency buried in noise
+var ref = new QDaqGenerator("ref");
+ref.waveform = "Sine";
+ref.frequency = 137;
+var sig = new QDaqGenerator("sig");
+sig.waveform = "Sine";
+sig.frequency = 137;
+sig.amplitude = 0.001;
+sig.noise = 0.01;
+
+var X = new QDaqChannel("X");
+var Y = new QDaqChannel("Y");
+var R = new QDaqChannel("R");
+R.digits = 6;
+var theta = new QDaqChannel("theta");
+
+var lockin = new QDaqLockIn("lockin");
+lockin.reference = "External";
+lockin.timeConstant = 0.3;
+lockin.filterOrder = 4;
+lockin.inputChannels = [sig, ref];
+lockin.outputChannels = [X, Y, R, theta];
+
+loop.appendChild(ref);
+loop.appendChild(sig);
+loop.appendChild(lockin);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("reference frequency (expected 137) = " + lockin.referenceFrequency);
+print("R (expected 0.001) = " + R.value());
+print("theta (expected ~0) = " + theta.value());
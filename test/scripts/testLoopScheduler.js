@@ -0,0 +1,49 @@
+print("Pooled loops sharing lock domains");
+
+function makeLoop(name, group) {
+    var l = new QDaqLoop(name);
+    l.period = 50;
+    l.pooled = true;
+    l.lockGroup = group;
+    var t = new QDaqChannel("t");
+    t.type = "Clock";
+    l.appendChild(t);
+    qdaq.appendChild(l);
+    return l;
+}
+
+// two loops in different lock domains
+var A = makeLoop("A", "g1");
+var B = makeLoop("B", "g2");
+A.arm();
+B.arm();
+print("A.worker = " + A.worker + ", B.worker = " + B.worker);
+
+// C joins both domains through its child loops:
+// A and B are migrated to the worker of C
+var C = makeLoop("C", "");
+var c1 = new QDaqLoop("c1");
+c1.lockGroup = "g1";
+var c2 = new QDaqLoop("c2");
+c2.lockGroup = "g2";
+C.appendChild(c1);
+C.appendChild(c2);
+C.arm();
+print("A.worker = " + A.worker + ", B.worker = " + B.worker + ", C.worker = " + C.worker +
+      " (expected all equal)");
+
+// an unrelated loop
+var D = makeLoop("D", "");
+D.arm();
+print("D.worker = " + D.worker);
+
+// the migrated loops keep running
+var nA = A.count, nB = B.count;
+wait(500);
+print("A ran " + (A.count - nA) + ", B ran " + (B.count - nB) + " times in 500 ms (expected ~10)");
+
+A.disarm();
+B.disarm();
+C.disarm();
+D.disarm();
+print("A.worker = " + A.worker + " (expected -1)");
@@ -0,0 +1,47 @@
+print("PID bank: 4 zones with first order plants");
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+loop.limit = 1000;
+
+var zones = 4;
+var T = [], u = [];
+for(var i=0; i<zones; i++) {
+    T.push(new QDaqChannel("T" + i));
+    u.push(new QDaqChannel("u" + i));
+}
+
+// one plant per zone with different gains
+var plants = [];
+for(var i=0; i<zones; i++) {
+    var sys = new QDaqFOPDT("sys" + i);
+    sys.kp = 1 + i;
+    sys.tp = 20;
+    sys.td = 2;
+    sys.inputChannels = [u[i]];
+    sys.outputChannels = [T[i]];
+    plants.push(sys);
+}
+
+var pid = new QDaqPidBank("pid");
+pid.inputChannels = T;
+pid.outputChannels = u;
+pid.samplingPeriod = 1;
+pid.setPoint = [0.2, 0.4, 0.6, 0.8];
+pid.gain = [1];   // the same for all zones
+pid.Ti = [20];
+pid.maxPower = [1];
+
+for(var i=0; i<zones; i++) loop.appendChild(u[i]);
+for(var i=0; i<zones; i++) loop.appendChild(plants[i]);
+for(var i=0; i<zones; i++) loop.appendChild(T[i]);
+loop.appendChild(pid);
+qdaq.appendChild(loop);
+
+loop.arm();
+pid.autoMode = true;
+while(loop.armed) wait(100);
+
+for(var i=0; i<zones; i++)
+    print("zone " + i + ": T = " + T[i].value() + " (set-point " + pid.setPoint.toArray()[i] + ")");
+print("power = " + pid.power.toArray());
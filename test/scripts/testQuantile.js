@@ -0,0 +1,42 @@
+print("Streaming quantiles and histogram of a noisy signal");
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+loop.limit = 2000;
+
+// normal noise, mean 1, std 0.1 (sum of 12 uniform)
+var x = new QDaqChannel("x");
+x.runCode = "var s = 0; for(var i=0; i<12; i++) s += Math.random(); this.push(1 + 0.1*(s - 6));";
+
+var p5 = new QDaqChannel("p5");
+var p50 = new QDaqChannel("p50");
+var p95 = new QDaqChannel("p95");
+
+var q = new QDaqQuantile("q");
+q.probabilities = [0.05, 0.5, 0.95];
+q.inputChannels = [x];
+q.outputChannels = [p5, p50, p95];
+
+var h = new QDaqHistogram("h");
+h.minimum = 0.5;
+h.maximum = 1.5;
+h.bins = 50;
+h.forgettingFactor = 0.999;
+h.inputChannels = [x];
+
+loop.appendChild(x);
+loop.appendChild(q);
+loop.appendChild(p5);
+loop.appendChild(p50);
+loop.appendChild(p95);
+loop.appendChild(h);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+print("count = " + q.count + ", min = " + q.minimum + ", max = " + q.maximum);
+print("P2 quantiles = " + q.quantiles.toArray() + " (expected 0.836, 1, 1.164)");
+print("histogram total = " + h.total + " (expected ~ 1000 with decay)");
+print("histogram quantiles = " + h.quantile(0.05) + ", " + h.quantile(0.5) + ", " + h.quantile(0.95));
+// in a ui with a QDaqPlotWidget: plot.plot(h.centers, h.counts)
@@ -0,0 +1,35 @@
+print("Off-line replay in virtual time");
+
+// recorded data
+var data = [];
+for(var i=0; i<10000; i++) data.push(Math.sin(0.01*i));
+
+// a loop running on a simulated clock
+var loop = new QDaqLoop("replay");
+loop.period = 10;
+loop.virtualTime = true;
+loop.virtualStart = 1.5e9; // fixed start, identical time stamps in every run
+
+var t = new QDaqChannel("t");
+t.type = "Clock";
+var x = new QDaqChannel("x");
+x.type = "Playback";
+x.playbackData = data;
+x.averaging = "Running";
+x.depth = 10;
+
+var buff = new QDaqDataBuffer("buff");
+buff.capacity = 10000;
+buff.channels = [t, x];
+
+loop.appendChild(t);
+loop.appendChild(x);
+loop.appendChild(buff);
+qdaq.appendChild(loop);
+
+// the loop stops by itself when x exhausts its data
+loop.arm();
+while(loop.armed) wait(100);
+
+print("Rows = " + buff.size);
+print("Simulated duration (s) = " + (loop.tickTime - loop.virtualStart));
@@ -0,0 +1,37 @@
+print("Streaming spectrum analyzer");
+
+// block mode loop on a simulated clock: 1 kHz sampling
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.blockSize = 100;
+loop.virtualTime = true;
+loop.limit = 100;
+
+// 50 Hz sine of amplitude 1 in white noise
+var sig = new QDaqGenerator("sig");
+sig.waveform = "Sine";
+sig.frequency = 50;
+sig.noise = 0.1;
+
+var spec = new QDaqSpectrum("spec");
+spec.inputChannels = [sig];
+spec.fftLength = 1000;
+spec.window = "FlatTop";
+spec.overlap = 0.5;
+spec.averages = 8;
+
+loop.appendChild(sig);
+loop.appendChild(spec);
+qdaq.appendChild(loop);
+
+loop.arm();
+while(loop.armed) wait(100);
+
+var f = spec.frequencies.toArray();
+var m = spec.magnitude.toArray();
+var k = 0;
+for(var i=1; i<m.length; i++) if (m[i] > m[k]) k = i;
+
+print("spectra = " + spec.count + ", dropped segments = " + spec.dropped);
+print("peak at " + f[k] + " Hz (expected 50), height = " + m[k] + " (expected 1)");
+print("noise PSD at 200 Hz (expected ~2e-5) = " + spec.psd.toArray()[200]);
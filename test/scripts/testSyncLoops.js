@@ -0,0 +1,61 @@
+print("Loops on a common time base");
+
+function makeLoop(name, period) {
+    var l = new QDaqLoop(name);
+    l.period = period;
+    var t = new QDaqChannel("t");
+    t.type = "Clock";
+    var buff = new QDaqDataBuffer("buff");
+    buff.capacity = 1000;
+    buff.channels = [t];
+    l.appendChild(t);
+    l.appendChild(buff);
+    qdaq.appendChild(l);
+    return l;
+}
+
+// A is the master, B runs on the same grid, C is shifted by 5 ms,
+// D runs at half the rate on A's grid, E is pooled
+var A = makeLoop("A", 10);
+var B = makeLoop("B", 10);
+B.syncMaster = A;
+var C = makeLoop("C", 10);
+C.syncMaster = A;
+C.phase = 5;
+var D = makeLoop("D", 20);
+D.syncMaster = A;
+var E = makeLoop("E", 10);
+E.syncMaster = A;
+E.pooled = true;
+
+A.arm();
+B.arm();
+C.arm();
+D.arm();
+E.arm();
+wait(2000);
+E.disarm();
+D.disarm();
+C.disarm();
+B.disarm();
+A.disarm();
+
+// time stamps in ms relative to A's first repetition,
+// all loops must be on A's 10 ms grid (C shifted by 5 ms)
+var t0 = A.buff.t.toArray()[0];
+function check(l, offset) {
+    var t = l.buff.t.toArray();
+    var dup = 0, offGrid = 0;
+    for(var i=0; i<t.length; i++) {
+        var ms = 1000*(t[i] - t0) - offset;
+        if (i && t[i] <= t[i-1]) dup++;
+        if (Math.abs(ms - 10*Math.round(ms/10)) > 0.01) offGrid++;
+    }
+    print(l.objectName + ": " + t.length + " rows, " + dup + " non-increasing, " +
+          offGrid + " off the grid (expected 0, 0)");
+}
+check(A, 0);
+check(B, 0);
+check(C, 5);
+check(D, 0);
+check(E, 0);
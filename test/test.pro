@@ -28,7 +28,25 @@ DISTFILES += \
     scripts/data.json \
     scripts/testConsolewidget.js \
     scripts/testVector.js \
-    scripts/testH5DataBuffer.js
+    scripts/testH5DataBuffer.js \
+    scripts/testLoopScheduler.js \
+    scripts/testBlockLoop.js \
+    scripts/testReplay.js \
+    scripts/testCompiled.js \
+    scripts/testChannelBank.js \
+    scripts/testGenerator.js \
+    scripts/testExpression.js \
+    scripts/testCalibration.js \
+    scripts/testCorrelator.js \
+    scripts/testDigitalFilters.js \
+    scripts/testSpectrum.js \
+    scripts/testLockIn.js \
+    scripts/testPidBank.js \
+    scripts/testKalman.js \
+    scripts/testQuantile.js \
+    scripts/testBudget.js \
+    scripts/testSyncLoops.js \
+    scripts/testAllocations.js
 
 FORMS += \
     ui/cryoTemperatureControl.ui \